@@ -0,0 +1,127 @@
+#include "bench.hh"
+
+#include "clapi/runtime/buffer_arena.hh"
+#include "clapi/runtime/enumerate.hh"
+
+#include <CL/cl.h>
+
+#include <cstddef>
+#include <print>
+#include <random>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+// Allocation rate of small transient buffers: raw `clCreateBuffer` against
+// `buffer_arena` with size-class free lists and in monotonic mode.
+//
+// Note: Each round allocates the batch of buffers of random sizes (256B - 64KiB), {{{
+//       then releases them all, as transient buffers of the frame would be.
+// }}}
+
+namespace
+{
+
+using bench::ok;
+using clapi::runtime::check;
+
+constexpr std::size_t batch = 1000;
+constexpr unsigned reps = 21;
+
+auto sizes() -> std::vector<std::size_t>
+{
+  std::mt19937 gen{42};
+  std::uniform_int_distribution<std::size_t> size{256, 64 << 10};
+
+  return std::views::iota(std::size_t(0), batch)
+         | std::views::transform([&] (std::size_t) { return size(gen); })
+         | std::ranges::to<std::vector>();
+}
+
+auto raw(cl_context ctx, const std::vector<std::size_t> &batch_sizes) -> bench::usec_t
+{
+  std::vector<cl_mem> live;
+  live.reserve(batch_sizes.size());
+
+  return bench::median_time(reps, [&] {
+    for (auto s : batch_sizes)
+      live.push_back(ok(check<::clCreateBuffer>(ctx, CL_MEM_READ_WRITE, s, nullptr)));
+
+    for (auto m : live) ok(check<::clReleaseMemObject>(m));
+    live.clear();
+  });
+}
+
+auto arena(cl_context ctx, cl_device_id dev, clapi::runtime::arena_mode mode,
+           const std::vector<std::size_t> &batch_sizes)
+  -> std::pair<bench::usec_t, clapi::runtime::buffer_arena_stats>
+{
+  using namespace clapi::runtime;
+
+  buffer_arena a{ctx, dev, {.mode = mode}};
+  buffer_arena_stats peak{};
+
+  std::vector<arena_buffer> live;
+  live.reserve(batch_sizes.size());
+
+  auto t = bench::median_time(reps, [&] {
+    for (auto s : batch_sizes) live.push_back(ok(a.allocate(s)));
+
+    peak = a.stats();
+    live.clear();
+
+    if (mode == arena_mode::monotonic) a.reset();
+  });
+
+  return {t, peak};
+}
+
+auto report(const char *what, bench::usec_t t) -> void
+{
+  std::println("{:>12} {:>12.1f} {:>14.0f}", what, t.count(),
+               double(batch) / t.count() * 1e6);
+}
+
+} // namespace
+
+int main() try
+{
+  using namespace clapi::runtime;
+
+  auto devices = enum_platform_devices(CL_DEVICE_TYPE_ALL) | std::ranges::to<std::vector>();
+
+  if (devices.empty())
+  {
+    std::println("No OpenCL device, nothing to measure");
+    return 0;
+  }
+
+  auto dev = std::get<cl_device_id>(devices.front());
+  auto ctx = ok(check<::clCreateContext>(nullptr, 1, &dev, nullptr, nullptr));
+
+  const auto batch_sizes = sizes();
+
+  std::println("{} buffers per round", batch);
+  std::println("{:>12} {:>12} {:>14}", "allocator", "time [us]", "allocs/s");
+
+  report("raw", raw(ctx, batch_sizes));
+
+  auto [t_lists, s_lists] = arena(ctx, dev, arena_mode::free_lists, batch_sizes);
+  report("free lists", t_lists);
+
+  auto [t_bump, s_bump] = arena(ctx, dev, arena_mode::monotonic, batch_sizes);
+  report("monotonic", t_bump);
+
+  for (auto [what, s] : {std::pair{"free lists", s_lists}, std::pair{"monotonic", s_bump}})
+    std::println("{:>12}: {} blocks, high water {} KiB, internal fragmentation {:.1f}%,"
+                 " reused {}/{}",
+                 what, s.blocks, s.high_water_bytes >> 10,
+                 100.0 * s.internal_fragmentation(), s.reused, s.allocations);
+
+  ok(check<::clReleaseContext>(ctx));
+}
+catch (clapi::error_code_t e)
+{
+   std::println(stderr, "OCL Error: {}", int(e));
+   return 1;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "clapi/runtime/measure.hh"
+
+#include <chrono>
+#include <concepts>
+#include <utility>
+
+namespace bench
+{
+
+using clock_t = std::chrono::steady_clock;
+using usec_t = std::chrono::duration<double, std::micro>;
+
+// Median wall time of `reps` runs of `fn` (after single warm-up run)
+template <std::invocable Fn_>
+[[nodiscard]]
+auto median_time(unsigned reps, Fn_ &&fn) -> usec_t
+{
+  return clapi::runtime::median_time<usec_t>(reps, std::forward<Fn_>(fn));
+}
+
+// Value of the checked API call, throws its error otherwise
+using clapi::runtime::ok;
+
+//----------------------------------------------------------------------------------------
+// keep - prevents compiler from discarding otherwise unused benchmarked result
+//----------------------------------------------------------------------------------------
+
+template <typename Ty_>
+auto keep(Ty_ &&value) -> void
+{
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+} // namespace bench
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,108 @@
+#include "bench.hh"
+
+#include "clapi/runtime/enumerate.hh"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <print>
+#include <ranges>
+#include <vector>
+
+// Device enumeration: the nested generators path against the eager one, filling the
+// caller provided (here stack) storage, and the generators allocating from the
+// (here stack backed) monotonic arena.
+//
+// Both time and number of heap allocations per enumeration are reported.
+//
+// Note: Generator flavour is the one selected at configuration time, {{{
+//       std::generator, or ranges-v3 experimental one for _clapi_MISSING_RANGES_CONCAT
+//       builds. Configure both ways to compare them.
+// }}}
+
+namespace
+{
+
+std::atomic<std::size_t> allocations{0};
+
+} // namespace
+
+auto operator new(std::size_t sz) -> void *
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  if (void *p = std::malloc(sz ? sz : 1)) return p;
+
+  throw std::bad_alloc{};
+}
+
+auto operator delete(void *p) noexcept -> void { std::free(p); }
+auto operator delete(void *p, std::size_t) noexcept -> void { std::free(p); }
+
+int main() try
+{
+  using namespace clapi::runtime;
+
+  constexpr unsigned reps = 101;
+
+  auto allocations_of = [] (auto &&fn) {
+    auto before = allocations.load();
+    fn();
+    return allocations.load() - before;
+  };
+
+  auto by_generator = [] {
+    auto devices = enum_platform_devices() | std::ranges::to<std::vector>();
+    bench::keep(devices);
+  };
+
+  auto by_pmr_generator = [] {
+    std::array<std::byte, 64 * 1024> buffer;
+    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size()};
+
+    std::array<full_device_id_t, 64> devices;
+    std::size_t n = 0;
+
+    for (auto dev : enum_platform_devices(std::allocator_arg, &arena))
+      if (n < devices.size()) devices[n++] = dev;
+
+    bench::keep(devices);
+  };
+
+  auto eager = [] {
+    std::array<cl_platform_id, 16> platforms_storage;
+    std::array<full_device_id_t, 64> devices_storage;
+
+    auto platforms = enum_platforms(platforms_storage);
+    auto devices = enum_platform_devices(platforms, devices_storage);
+    bench::keep(devices);
+  };
+
+#if _clapi_MISSING_RANGES_CONCAT
+  std::println("generator: ranges::experimental::generator");
+#else
+  std::println("generator: std::generator");
+#endif
+
+  std::println("{:>10} {:>12} {:>12}", "path", "time [us]", "allocations");
+
+  std::println("{:>10} {:>12.2f} {:>12}", "generator",
+               bench::median_time(reps, by_generator).count(),
+               allocations_of(by_generator));
+
+  std::println("{:>10} {:>12.2f} {:>12}", "pmr",
+               bench::median_time(reps, by_pmr_generator).count(),
+               allocations_of(by_pmr_generator));
+
+  std::println("{:>10} {:>12.2f} {:>12}", "eager",
+               bench::median_time(reps, eager).count(),
+               allocations_of(eager));
+}
+catch (clapi::error_code_t e)
+{
+   std::println(stderr, "OCL Error: {}", int(e));
+   return 1;
+}
@@ -0,0 +1,219 @@
+#include "bench.hh"
+
+#include "clapi/runtime/command_graph.hh"
+#include "clapi/runtime/enumerate.hh"
+
+#include <CL/cl.h>
+
+#include <cstddef>
+#include <print>
+#include <ranges>
+#include <span>
+#include <vector>
+
+// Diamond-shaped pipeline: upload, two independent kernels reading the upload,
+// the kernel joining both of them, then readback. Serialized on single in-order queue,
+// against `command_graph`, where two branches may overlap on the device.
+//
+// Note: Branches are compute bound on few work-groups, so that either of {{{
+//       them alone leaves most of the device idle.
+// }}}
+
+namespace
+{
+
+using bench::ok;
+using clapi::runtime::check;
+
+constexpr const char *diamond_src = R"CL(
+kernel void branch(global const float *in, global float *out, float k, uint iters)
+{
+  size_t i = get_global_id(0);
+  float v = in[i];
+
+  for (uint n = 0; n < iters; ++n) v = fma(v, k, 0.5f);
+
+  out[i] = v;
+}
+
+kernel void join(global const float *a, global const float *b, global float *out)
+{
+  size_t i = get_global_id(0);
+  out[i] = a[i] + b[i];
+}
+)CL";
+
+constexpr std::size_t elements = std::size_t(1) << 14;
+constexpr cl_uint iters = 1u << 14;
+constexpr unsigned reps = 21;
+
+struct diamond
+{
+  cl_context ctx;
+  cl_program program;
+  cl_kernel left, right, join;
+  cl_mem in, a, b, out;
+  std::vector<float> host_in, host_out;
+};
+
+auto make_diamond(cl_device_id dev) -> diamond
+{
+  diamond d{};
+
+  d.ctx = ok(check<::clCreateContext>(nullptr, 1, &dev, nullptr, nullptr));
+
+  const char *src = diamond_src;
+  d.program = ok(check<::clCreateProgramWithSource>(d.ctx, 1, &src, nullptr));
+  ok(check<::clBuildProgram>(d.program, 1, &dev, nullptr, nullptr, nullptr));
+
+  d.left = ok(check<::clCreateKernel>(d.program, "branch"));
+  d.right = ok(check<::clCreateKernel>(d.program, "branch"));
+  d.join = ok(check<::clCreateKernel>(d.program, "join"));
+
+  const auto bytes = elements * sizeof(float);
+
+  for (auto *m : {&d.in, &d.a, &d.b, &d.out})
+    *m = ok(check<::clCreateBuffer>(d.ctx, CL_MEM_READ_WRITE, bytes, nullptr));
+
+  d.host_in.assign(elements, 1.0f);
+  d.host_out.resize(elements);
+
+  const float kl = 0.999f, kr = 1.001f;
+
+  ok(check<::clSetKernelArg>(d.left, 0, sizeof(cl_mem), &d.in));
+  ok(check<::clSetKernelArg>(d.left, 1, sizeof(cl_mem), &d.a));
+  ok(check<::clSetKernelArg>(d.left, 2, sizeof(kl), &kl));
+  ok(check<::clSetKernelArg>(d.left, 3, sizeof(iters), &iters));
+
+  ok(check<::clSetKernelArg>(d.right, 0, sizeof(cl_mem), &d.in));
+  ok(check<::clSetKernelArg>(d.right, 1, sizeof(cl_mem), &d.b));
+  ok(check<::clSetKernelArg>(d.right, 2, sizeof(kr), &kr));
+  ok(check<::clSetKernelArg>(d.right, 3, sizeof(iters), &iters));
+
+  ok(check<::clSetKernelArg>(d.join, 0, sizeof(cl_mem), &d.a));
+  ok(check<::clSetKernelArg>(d.join, 1, sizeof(cl_mem), &d.b));
+  ok(check<::clSetKernelArg>(d.join, 2, sizeof(cl_mem), &d.out));
+
+  return d;
+}
+
+auto release(diamond &d) -> void
+{
+  for (auto m : {d.in, d.a, d.b, d.out}) ok(check<::clReleaseMemObject>(m));
+  for (auto k : {d.left, d.right, d.join}) ok(check<::clReleaseKernel>(k));
+
+  ok(check<::clReleaseProgram>(d.program));
+  ok(check<::clReleaseContext>(d.ctx));
+}
+
+// Stages of the diamond, as graph operations
+
+auto upload(diamond &d) -> clapi::runtime::enqueue_op
+{
+  return [&d] (cl_command_queue q, std::span<const cl_event> wait, cl_event *done) {
+    return check<::clEnqueueWriteBuffer>(q, d.in, CL_FALSE, 0, elements * sizeof(float),
+                                         d.host_in.data(), cl_uint(wait.size()),
+                                         wait.empty() ? nullptr : wait.data(), done);
+  };
+}
+
+auto launch(cl_kernel k) -> clapi::runtime::enqueue_op
+{
+  return [k] (cl_command_queue q, std::span<const cl_event> wait, cl_event *done) {
+    return check<::clEnqueueNDRangeKernel>(q, k, 1, nullptr, &elements, nullptr,
+                                           cl_uint(wait.size()),
+                                           wait.empty() ? nullptr : wait.data(), done);
+  };
+}
+
+auto readback(diamond &d) -> clapi::runtime::enqueue_op
+{
+  return [&d] (cl_command_queue q, std::span<const cl_event> wait, cl_event *done) {
+    return check<::clEnqueueReadBuffer>(q, d.out, CL_FALSE, 0, elements * sizeof(float),
+                                        d.host_out.data(), cl_uint(wait.size()),
+                                        wait.empty() ? nullptr : wait.data(), done);
+  };
+}
+
+auto build_graph(diamond &d) -> clapi::runtime::command_graph
+{
+  clapi::runtime::command_graph g;
+
+  auto up = g.add(upload(d));
+  auto left = g.add(launch(d.left), {up});
+  auto right = g.add(launch(d.right), {up});
+  auto join = g.add(launch(d.join), {left, right});
+  g.add(readback(d), {join});
+
+  return g;
+}
+
+auto serialized(cl_device_id dev) -> bench::usec_t
+{
+  auto d = make_diamond(dev);
+  auto q = ok(check<::clCreateCommandQueueWithProperties>(d.ctx, dev, nullptr));
+
+  // Same operations, in order of the nodes, on single in-order queue
+  auto t = bench::median_time(reps, [&] {
+    ok(upload(d)(q, {}, nullptr));
+    ok(launch(d.left)(q, {}, nullptr));
+    ok(launch(d.right)(q, {}, nullptr));
+    ok(launch(d.join)(q, {}, nullptr));
+    ok(readback(d)(q, {}, nullptr));
+
+    ok(check<::clFinish>(q));
+  });
+
+  ok(check<::clReleaseCommandQueue>(q));
+  release(d);
+
+  return t;
+}
+
+auto graph(cl_device_id dev, bool &out_of_order) -> bench::usec_t
+{
+  auto d = make_diamond(dev);
+  auto queues = ok(clapi::runtime::make_graph_queues(d.ctx, dev));
+  auto g = build_graph(d);
+
+  out_of_order = queues.out_of_order;
+
+  auto t = bench::median_time(reps, [&] { ok(ok(g.run(queues)).wait()); });
+
+  queues.queues.clear();
+  release(d);
+
+  return t;
+}
+
+} // namespace
+
+int main() try
+{
+  using namespace clapi::runtime;
+
+  auto devices = enum_platform_devices(CL_DEVICE_TYPE_ALL) | std::ranges::to<std::vector>();
+
+  if (devices.empty())
+  {
+    std::println("No OpenCL device, nothing to measure");
+    return 0;
+  }
+
+  auto dev = std::get<cl_device_id>(devices.front());
+  bool out_of_order = false;
+
+  auto t_serial = serialized(dev);
+  auto t_graph = graph(dev, out_of_order);
+
+  std::println("{:>12} {:>12}", "schedule", "time [us]");
+  std::println("{:>12} {:>12.1f}", "serialized", t_serial.count());
+  std::println("{:>12} {:>12.1f} ({})", "graph", t_graph.count(),
+               out_of_order ? "out-of-order queue" : "in-order queues");
+  std::println("speedup {:.2f}x", t_serial / t_graph);
+}
+catch (clapi::error_code_t e)
+{
+   std::println(stderr, "OCL Error: {}", int(e));
+   return 1;
+}
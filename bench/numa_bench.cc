@@ -0,0 +1,204 @@
+#include "bench.hh"
+
+#include "clapi/runtime/enumerate.hh"
+#include "clapi/runtime/numa.hh"
+#include "clapi/runtime/partition.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <print>
+#include <ranges>
+#include <span>
+#include <vector>
+
+// Memory bandwidth (STREAM triad) of the CPU device as whole, against the same device
+// partitioned by NUMA domain, where each of sub-devices works on the memory bound
+// to its own node.
+//
+// Note: Meant for multi-socket hosts with PoCL (or any CPU device supporting {{{
+//       `CL_DEVICE_AFFINITY_DOMAIN_NUMA`). Single node hosts are reported and skipped.
+// }}}
+
+namespace
+{
+
+using bench::ok;
+using clapi::runtime::check;
+
+constexpr const char *triad_src = R"CL(
+kernel void triad(global float *a, global const float *b, global const float *c, float s)
+{
+  size_t i = get_global_id(0);
+  a[i] = b[i] + s * c[i];
+}
+)CL";
+
+constexpr std::size_t elements = std::size_t(1) << 25;
+constexpr unsigned reps = 21;
+
+struct triad_job
+{
+  cl_command_queue queue;
+  cl_kernel kernel;
+  std::vector<cl_mem> buffers;
+  std::size_t count;
+};
+
+auto build_triad(cl_context ctx, std::span<const cl_device_id> devices) -> cl_program
+{
+  const char *src = triad_src;
+  auto program = ok(check<::clCreateProgramWithSource>(ctx, 1, &src, nullptr));
+
+  ok(check<::clBuildProgram>(program, cl_uint(devices.size()), devices.data(),
+                             nullptr, nullptr, nullptr));
+  return program;
+}
+
+auto make_job(cl_context ctx, cl_device_id dev, cl_program program,
+              std::span<void * const> host, std::size_t count) -> triad_job
+{
+  triad_job job{
+    .queue = ok(check<::clCreateCommandQueueWithProperties>(ctx, dev, nullptr)),
+    .kernel = ok(check<::clCreateKernel>(program, "triad")),
+    .buffers = {},
+    .count = count,
+  };
+
+  for (auto *p : host)
+  {
+    auto flags = p ? CL_MEM_USE_HOST_PTR : CL_MEM_ALLOC_HOST_PTR;
+    job.buffers.push_back(ok(check<::clCreateBuffer>(ctx, flags, count * sizeof(float), p)));
+  }
+
+  const float scale = 3.0f;
+
+  for (cl_uint i = 0; i < job.buffers.size(); ++i)
+    ok(check<::clSetKernelArg>(job.kernel, i, sizeof(cl_mem), &job.buffers[i]));
+
+  ok(check<::clSetKernelArg>(job.kernel, 3, sizeof(scale), &scale));
+
+  return job;
+}
+
+auto release(triad_job &job) -> void
+{
+  for (auto b : job.buffers) ok(check<::clReleaseMemObject>(b));
+
+  ok(check<::clReleaseKernel>(job.kernel));
+  ok(check<::clReleaseCommandQueue>(job.queue));
+}
+
+// All jobs run concurrently
+auto run(std::span<triad_job> jobs) -> void
+{
+  for (auto &job : jobs)
+    ok(check<::clEnqueueNDRangeKernel>(job.queue, job.kernel, 1, nullptr, &job.count,
+                                        nullptr, 0, nullptr, nullptr));
+
+  for (auto &job : jobs) ok(check<::clFinish>(job.queue));
+}
+
+auto report(const char *what, std::size_t count, bench::usec_t t) -> void
+{
+  // Triad reads two arrays and writes one
+  const double bytes = 3.0 * double(count) * sizeof(float);
+
+  std::println("{:>12} {:>12.1f} {:>12.2f}", what, t.count(), bytes / t.count() / 1e3);
+}
+
+auto monolithic(cl_device_id dev) -> bench::usec_t
+{
+  auto ctx = ok(check<::clCreateContext>(nullptr, 1, &dev, nullptr, nullptr));
+  auto program = build_triad(ctx, {&dev, 1});
+
+  void *host[3] = {};
+  triad_job jobs[] = {make_job(ctx, dev, program, host, elements)};
+
+  auto t = bench::median_time(reps, [&] { run(jobs); });
+
+  release(jobs[0]);
+  ok(check<::clReleaseProgram>(program));
+  ok(check<::clReleaseContext>(ctx));
+
+  return t;
+}
+
+auto partitioned(const clapi::runtime::sub_devices &subs) -> bench::usec_t
+{
+  using clapi::runtime::node_memory;
+
+  auto ids = subs.ids();
+  auto ctx = ok(check<::clCreateContext>(nullptr, cl_uint(ids.size()), ids.data(),
+                                         nullptr, nullptr));
+  auto program = build_triad(ctx, ids);
+
+  const auto count = elements / ids.size();
+
+  std::vector<node_memory> memory;
+  std::vector<triad_job> jobs;
+
+  for (auto [node, dev] : std::views::enumerate(ids))
+  {
+    void *host[3];
+
+    for (auto &p : host)
+    {
+      auto &m = memory.emplace_back(count * sizeof(float), unsigned(node));
+      std::ranges::fill(m.as_span<float>(), 1.0f);
+      p = m.data();
+    }
+
+    if (not memory.back().bound())
+      std::println(stderr, "warning: memory of node {} is not bound", node);
+
+    jobs.push_back(make_job(ctx, dev, program, host, count));
+  }
+
+  auto t = bench::median_time(reps, [&] { run(jobs); });
+
+  for (auto &job : jobs) release(job);
+  ok(check<::clReleaseProgram>(program));
+  ok(check<::clReleaseContext>(ctx));
+
+  return t;
+}
+
+} // namespace
+
+int main() try
+{
+  using namespace clapi::runtime;
+
+  auto cpus = enum_platform_devices(CL_DEVICE_TYPE_CPU) | std::ranges::to<std::vector>();
+
+  if (cpus.empty())
+  {
+    std::println("No CPU OpenCL device, nothing to measure");
+    return 0;
+  }
+
+  auto dev = std::get<cl_device_id>(cpus.front());
+
+  if (numa_node_count() < 2 or not can_partition(dev, affinity_domain::numa))
+  {
+    std::println("Single NUMA node (or device not partitionable by NUMA domain),"
+                 " nothing to compare");
+    return 0;
+  }
+
+  auto subs = partition_by_numa(dev);
+
+  std::println("{} NUMA sub-devices, {} MiB per array",
+               subs.size(), elements * sizeof(float) >> 20);
+  std::println("{:>12} {:>12} {:>12}", "device", "time [us]", "GB/s");
+
+  report("monolithic", elements, monolithic(dev));
+  report("per-node", elements / subs.size() * subs.size(), partitioned(subs));
+}
+catch (clapi::error_code_t e)
+{
+   std::println(stderr, "OCL Error: {}", int(e));
+   return 1;
+}
@@ -0,0 +1,91 @@
+#include "bench.hh"
+
+#include "clapi/runtime/enumerate.hh"
+#include "clapi/runtime/probe.hh"
+#include "clapi/runtime/query.hh"
+
+#include <print>
+#include <ranges>
+#include <string>
+#include <vector>
+
+// End-to-end device selection time against the number of devices.
+//
+// Each device gets the same driver round trips `clapi` select_devices does, once
+// strictly one after another, then fanned out with `clapi::runtime::probe`.
+//
+// Hosts rarely have more than few devices, thus larger device counts are emulated by
+// probing discovered devices repeatedly.
+
+namespace
+{
+
+using namespace clapi::runtime;
+
+struct probed_t
+{
+  bool available;
+  std::string pprofile;
+  std::string dprofile;
+  std::string pname;
+  std::string dname;
+};
+
+auto select_probe(const full_device_id_t &dev) -> probed_t
+{
+  auto [p, d, _] = dev;
+
+  return {
+    .available = query_bool_property_(DevInfo, d, CL_DEVICE_AVAILABLE),
+    .pprofile = query_string_property_(PlatInfo, p, CL_PLATFORM_PROFILE),
+    .dprofile = query_string_property_(DevInfo, d, CL_DEVICE_PROFILE),
+    .pname = query_string_property_(PlatInfo, p, CL_PLATFORM_NAME),
+    .dname = query_string_property_(DevInfo, d, CL_DEVICE_NAME),
+  };
+}
+
+} // namespace
+
+int main() try
+{
+  using std::vector;
+
+  constexpr unsigned reps = 15;
+
+  auto discovered = enum_platform_devices() | std::ranges::to<vector>();
+
+  if (discovered.empty())
+  {
+    std::println("No OpenCL devices found");
+    return 0;
+  }
+
+  worker_pool pool;
+
+  std::println("{:>8} {:>16} {:>16} {:>8}",
+               "devices", "sequential [us]", "probe [us]", "speedup");
+
+  for (std::size_t n : {1, 2, 4, 8, 16, 32, 64})
+  {
+    vector<full_device_id_t> devices;
+    for (std::size_t i = 0; i < n; ++i)
+      devices.push_back(discovered[i % discovered.size()]);
+
+    auto sequential = bench::median_time(reps, [&] {
+      for (const auto &d : devices) bench::keep(select_probe(d));
+    });
+
+    auto parallel = bench::median_time(reps, [&] {
+      bench::keep(probe(pool, devices, select_probe));
+    });
+
+    std::println("{:>8} {:>16.1f} {:>16.1f} {:>8.2f}",
+                 n, sequential.count(), parallel.count(),
+                 sequential / parallel);
+  }
+}
+catch (clapi::error_code_t e)
+{
+   std::println(stderr, "OCL Error: {}", int(e));
+   return 1;
+}
@@ -0,0 +1,163 @@
+#include "bench.hh"
+
+#include "clapi/runtime/enumerate.hh"
+#include "clapi/runtime/host_buffer.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <print>
+#include <ranges>
+#include <vector>
+
+// Host data through the kernel and back: explicit copies (`clEnqueueWriteBuffer`,
+// `clEnqueueReadBuffer`) of the device buffer, against `host_buffer` shared in place,
+// touched by the host through mapped spans.
+//
+// Note: Meant for PoCL (or any CPU device), where the copy is pure overhead. {{{
+//       Integrated GPUs are expected to behave alike.
+// }}}
+
+namespace
+{
+
+using bench::ok;
+using clapi::runtime::check;
+
+constexpr const char *scale_src = R"CL(
+kernel void scale(global float *a, float s)
+{
+  size_t i = get_global_id(0);
+  a[i] *= s;
+}
+)CL";
+
+constexpr std::size_t elements = std::size_t(1) << 24;
+constexpr unsigned reps = 21;
+
+struct setup
+{
+  cl_context ctx;
+  cl_command_queue queue;
+  cl_program program;
+  cl_kernel kernel;
+};
+
+auto make_setup(cl_device_id dev) -> setup
+{
+  setup s{};
+
+  s.ctx = ok(check<::clCreateContext>(nullptr, 1, &dev, nullptr, nullptr));
+  s.queue = ok(check<::clCreateCommandQueueWithProperties>(s.ctx, dev, nullptr));
+
+  const char *src = scale_src;
+  s.program = ok(check<::clCreateProgramWithSource>(s.ctx, 1, &src, nullptr));
+  ok(check<::clBuildProgram>(s.program, 1, &dev, nullptr, nullptr, nullptr));
+
+  s.kernel = ok(check<::clCreateKernel>(s.program, "scale"));
+
+  const float factor = 1.0001f;
+  ok(check<::clSetKernelArg>(s.kernel, 1, sizeof(factor), &factor));
+
+  return s;
+}
+
+auto release(setup &s) -> void
+{
+  ok(check<::clReleaseKernel>(s.kernel));
+  ok(check<::clReleaseProgram>(s.program));
+  ok(check<::clReleaseCommandQueue>(s.queue));
+  ok(check<::clReleaseContext>(s.ctx));
+}
+
+auto launch(const setup &s, cl_mem buffer) -> void
+{
+  ok(check<::clSetKernelArg>(s.kernel, 0, sizeof(buffer), &buffer));
+  ok(check<::clEnqueueNDRangeKernel>(s.queue, s.kernel, 1, nullptr, &elements, nullptr,
+                                     0, nullptr, nullptr));
+}
+
+auto copies(const setup &s) -> bench::usec_t
+{
+  const auto bytes = elements * sizeof(float);
+
+  std::vector<float> host(elements, 1.0f);
+  auto buffer = ok(check<::clCreateBuffer>(s.ctx, CL_MEM_READ_WRITE, bytes, nullptr));
+
+  auto t = bench::median_time(reps, [&] {
+    std::ranges::fill(host, 1.0f);
+
+    ok(check<::clEnqueueWriteBuffer>(s.queue, buffer, CL_FALSE, 0, bytes, host.data(),
+                                     0, nullptr, nullptr));
+    launch(s, buffer);
+    ok(check<::clEnqueueReadBuffer>(s.queue, buffer, CL_TRUE, 0, bytes, host.data(),
+                                    0, nullptr, nullptr));
+    bench::keep(host[elements / 2]);
+  });
+
+  ok(check<::clReleaseMemObject>(buffer));
+
+  return t;
+}
+
+auto zero_copy(const setup &s, cl_device_id dev) -> bench::usec_t
+{
+  using namespace clapi::runtime;
+
+  host_buffer buffer{s.ctx, dev, elements * sizeof(float), CL_MEM_READ_WRITE,
+                     host_buffer_mode::use_host_ptr};
+
+  auto t = bench::median_time(reps, [&] {
+    std::ranges::fill(buffer.map<float>(s.queue, CL_MAP_WRITE_INVALIDATE_REGION), 1.0f);
+
+    launch(s, buffer);
+
+    auto out = buffer.map<float>(s.queue, CL_MAP_READ);
+    bench::keep(out[elements / 2]);
+  });
+
+  ok(check<::clFinish>(s.queue));
+
+  return t;
+}
+
+auto report(const char *what, bench::usec_t t) -> void
+{
+  // Written to the device and read back
+  const double bytes = 2.0 * double(elements) * sizeof(float);
+
+  std::println("{:>12} {:>12.1f} {:>12.2f}", what, t.count(), bytes / t.count() / 1e3);
+}
+
+} // namespace
+
+int main() try
+{
+  using namespace clapi::runtime;
+
+  auto cpus = enum_platform_devices(CL_DEVICE_TYPE_CPU) | std::ranges::to<std::vector>();
+
+  if (cpus.empty())
+  {
+    std::println("No CPU OpenCL device, nothing to measure");
+    return 0;
+  }
+
+  auto dev = std::get<cl_device_id>(cpus.front());
+  auto s = make_setup(dev);
+
+  std::println("{} MiB buffer, aligned to {} bytes for zero-copy",
+               elements * sizeof(float) >> 20, host_buffer::alignment_for(dev));
+  std::println("{:>12} {:>12} {:>12}", "transfer", "time [us]", "GB/s");
+
+  report("copies", copies(s));
+  report("zero-copy", zero_copy(s, dev));
+
+  release(s);
+}
+catch (clapi::error_code_t e)
+{
+   std::println(stderr, "OCL Error: {}", int(e));
+   return 1;
+}
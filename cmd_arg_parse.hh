@@ -33,6 +33,10 @@ consteval auto allowed_cmd_switches() {
     "--all-types"sv,
     "--want-legacy"sv,
     "--just-first"sv,
+    "--metrics"sv,
+    "--microbench"sv,
+    "--microbench-rerun"sv,
+    "--setup"sv,
 //   "--help"sv,
   };
   return auto(switches);
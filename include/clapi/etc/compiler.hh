@@ -18,6 +18,13 @@
 # define clapi_inline_stmt likely
 #endif
 
+// For paths rarely taken, kept out of line from the hot ones
+#if __has_cpp_attribute(gnu::cold) && __has_cpp_attribute(gnu::noinline)
+# define clapi_cold_fn gnu::cold, gnu::noinline
+#else
+# define clapi_cold_fn
+#endif
+
 // Compiler can do that, so use it, things like pack indexing
 // are much faster to compile when not emulated.
 #define _clapi_BEGIN_ALLOW_CPP26() \
@@ -0,0 +1,403 @@
+#pragma once
+
+#include "clapi/etc/basic.hh"
+#include "clapi/runtime/device.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+class buffer_arena;
+
+enum class arena_mode
+{
+  free_lists,   // size classes (powers of two), released buffers are reused
+  monotonic,    // bump allocation only, memory comes back all at once by `reset()`
+};
+
+struct buffer_arena_options
+{
+  std::size_t block_bytes = std::size_t(64) << 20;
+  arena_mode mode = arena_mode::free_lists;
+  ::cl_mem_flags flags = CL_MEM_READ_WRITE;
+
+  // Smallest size class, raised to the base address alignment of the device
+  std::size_t min_class_bytes = 256;
+};
+
+struct buffer_arena_stats
+{
+  std::uint64_t allocations;
+  std::uint64_t reused;        // served by the free list, no driver call at all
+  std::uint64_t dedicated;     // larger than the block, own `clCreateBuffer`
+  std::size_t blocks;
+  std::size_t reserved_bytes;  // of blocks
+  std::size_t carved_bytes;    // handed out of blocks so far (including free lists)
+  std::size_t in_use_bytes;    // of live buffers, by size class (or aligned size)
+  std::size_t requested_bytes; // of live buffers, as requested
+  std::size_t high_water_bytes;
+
+  // Slack of size classes and alignment, of live buffers
+  [[nodiscard]]
+  auto internal_fragmentation() const noexcept -> double
+  {
+    return in_use_bytes ? 1.0 - double(requested_bytes) / double(in_use_bytes) : 0.0;
+  }
+
+  // Carved, but not in use (free lists, or dead buffers of monotonic arena)
+  [[nodiscard]]
+  auto external_fragmentation() const noexcept -> double
+  {
+    return carved_bytes ? double(carved_bytes - std::min(carved_bytes, in_use_bytes))
+                          / double(carved_bytes)
+                        : 0.0;
+  }
+};
+
+} // namespace clapi::runtime
+
+namespace clapi::_detail::runtime
+{
+
+// `bytes` rounded up to multiple of `align`, a power of two
+constexpr auto _align_up(std::size_t bytes, std::size_t align) noexcept -> std::size_t
+{
+  return (bytes + align - 1) & ~(align - 1);
+}
+
+// Power of two size classes, class 0 is of `min_class` bytes (a power of two)
+constexpr auto _size_class(std::size_t bytes, std::size_t min_class) noexcept -> unsigned
+{
+  return unsigned(std::bit_width(std::bit_ceil(std::max(bytes, min_class)))
+                  - std::bit_width(min_class));
+}
+
+constexpr auto _size_class_bytes(unsigned cls, std::size_t min_class) noexcept
+  -> std::size_t
+{
+  return min_class << cls;
+}
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// arena_buffer - sub-buffer of the arena, returned to it on destruction
+//----------------------------------------------------------------------------------------
+
+class arena_buffer
+{
+public:
+  arena_buffer() noexcept = default;
+
+  arena_buffer(arena_buffer &&other) noexcept :
+    _arena(std::exchange(other._arena, nullptr)),
+    _mem(std::move(other._mem)),
+    _size(other._size),
+    _class(other._class)
+  {}
+
+  auto operator=(arena_buffer &&other) noexcept -> arena_buffer &
+  {
+    arena_buffer{std::move(other)}.swap(*this);
+    return *this;
+  }
+
+  ~arena_buffer();
+
+  [[nodiscard]]
+  auto get() const noexcept -> ::cl_mem { return _mem.get(); }
+
+  operator ::cl_mem() const noexcept { return _mem.get(); }
+
+  explicit operator bool() const noexcept { return bool(_mem); }
+
+  // Requested size, the sub-buffer may be larger (size class)
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t { return _size; }
+
+  auto swap(arena_buffer &other) noexcept -> void
+  {
+    std::swap(_arena, other._arena);
+    _mem.swap(other._mem);
+    std::swap(_size, other._size);
+    std::swap(_class, other._class);
+  }
+
+private:
+  friend buffer_arena;
+
+  arena_buffer(buffer_arena *arena, mem_handle mem, std::size_t size, unsigned cls) noexcept :
+    _arena(arena), _mem(std::move(mem)), _size(size), _class(cls)
+  {}
+
+  buffer_arena *_arena = nullptr;
+  mem_handle _mem;
+  std::size_t _size = 0;
+  unsigned _class = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// buffer_arena - sub-buffers carved out of large device allocations
+//----------------------------------------------------------------------------------------
+//
+// `clCreateBuffer` costs tens of microseconds on most drivers, the arena reserves
+// blocks of `block_bytes` and carves `clCreateSubBuffer`s out of them, at offsets
+// aligned to `CL_DEVICE_MEM_BASE_ADDR_ALIGN`.
+//
+// In `free_lists` mode sizes are rounded up to power of two classes, released
+// sub-buffers are kept (with their `cl_mem`) in the free list of the class and handed
+// out again with no driver call. In `monotonic` mode sizes are just aligned, releasing
+// is no-op, and all of blocks are rewound by `reset()`.
+//
+// Note: Requests over the block size get a dedicated buffer. {{{
+//       `reset()` requires all of the arena's buffers released, it fails otherwise.
+//       Blocks are reserved under the lock, sub-buffers are created outside of it.
+//       The arena must outlive its buffers.
+// }}}
+
+class buffer_arena : immovable<buffer_arena>
+{
+public:
+  buffer_arena(::cl_context ctx, ::cl_device_id dev, buffer_arena_options options = {}) :
+    _options(options)
+  {
+    const std::size_t align = runtime::device{dev}.mem_base_addr_align();
+
+    auto retained = context_handle::retain(ctx);
+    if (!retained) [[unlikely]] throw retained.error();
+
+    _ctx = *std::move(retained);
+
+    _align = std::bit_ceil(std::max<std::size_t>(align, 1));
+    _options.min_class_bytes = std::bit_ceil(std::max(_options.min_class_bytes, _align));
+    _options.block_bytes = std::max(_options.block_bytes, _options.min_class_bytes);
+  }
+
+  [[nodiscard]]
+  auto allocate(std::size_t bytes) -> error_or<arena_buffer>
+  {
+    bytes = std::max<std::size_t>(bytes, 1);
+
+    const bool classes = _options.mode == arena_mode::free_lists;
+    const unsigned cls = classes ? _class_of(bytes) : 0;
+    const std::size_t size = classes ? _class_bytes(cls) : _aligned(bytes);
+
+    if (size > _options.block_bytes) [[unlikely]] return _dedicated(bytes);
+
+    _carved_t carved;
+    {
+      std::scoped_lock lock{_mutex};
+
+      ++_stats.allocations;
+
+      if (classes and cls < _free.size() and not _free[cls].empty()) [[likely]]
+      {
+        auto mem = std::move(_free[cls].back());
+        _free[cls].pop_back();
+
+        ++_stats.reused;
+        _track(size, bytes);
+
+        return arena_buffer{this, std::move(mem), bytes, cls};
+      }
+
+      auto c = _carve(size);
+      if (!c) [[unlikely]] return std::unexpected(c.error());
+
+      carved = *c;
+      _track(size, bytes);
+    }
+
+    // Flags of the block are inherited
+    auto mem = adopt(check<::clCreateSubBuffer>(carved.block, 0,
+                                                CL_BUFFER_CREATE_TYPE_REGION,
+                                                &carved.region));
+    if (!mem) [[unlikely]]
+    {
+      _release(size, bytes);
+      return std::unexpected(mem.error());
+    }
+
+    return arena_buffer{this, *std::move(mem), bytes, cls};
+  }
+
+  // Rewinds all of blocks (and drops free lists), false when some buffers are still live
+  auto reset() -> bool
+  {
+    std::scoped_lock lock{_mutex};
+
+    if (_live) return false;
+
+    _free.clear();
+    _block = 0;
+    _used = 0;
+    _stats.carved_bytes = 0;
+
+    return true;
+  }
+
+  [[nodiscard]]
+  auto stats() const -> buffer_arena_stats
+  {
+    std::scoped_lock lock{_mutex};
+
+    auto s = _stats;
+    s.blocks = _blocks.size();
+    s.reserved_bytes = _blocks.size() * _options.block_bytes;
+
+    return s;
+  }
+
+  [[nodiscard]]
+  auto alignment() const noexcept -> std::size_t { return _align; }
+
+private:
+  friend arena_buffer;
+
+  static constexpr unsigned _dedicated_class = ~0u;
+
+  auto _aligned(std::size_t bytes) const noexcept -> std::size_t
+  {
+    return _detail::runtime::_align_up(bytes, _align);
+  }
+
+  auto _class_of(std::size_t bytes) const noexcept -> unsigned
+  {
+    return _detail::runtime::_size_class(bytes, _options.min_class_bytes);
+  }
+
+  auto _class_bytes(unsigned cls) const noexcept -> std::size_t
+  {
+    return _detail::runtime::_size_class_bytes(cls, _options.min_class_bytes);
+  }
+
+  struct _carved_t
+  {
+    ::cl_mem block;
+    ::cl_buffer_region region;
+  };
+
+  // Under the lock
+  auto _carve(std::size_t size) -> error_or<_carved_t>
+  {
+    if (_block == _blocks.size() or _used + size > _options.block_bytes)
+    {
+      if (_block < _blocks.size() and _used != 0) ++_block;
+      _used = 0;
+
+      if (_block == _blocks.size())
+      {
+        auto block = adopt(check<::clCreateBuffer>(_ctx.get(), _options.flags,
+                                                   _options.block_bytes, nullptr));
+        if (!block) [[unlikely]] return std::unexpected(block.error());
+
+        _blocks.push_back(*std::move(block));
+      }
+    }
+
+    _carved_t carved{_blocks[_block].get(), {_used, size}};
+
+    _used += size;
+    _stats.carved_bytes += size;
+
+    return carved;
+  }
+
+  auto _dedicated(std::size_t bytes) -> error_or<arena_buffer>
+  {
+    auto mem = adopt(check<::clCreateBuffer>(_ctx.get(), _options.flags, bytes, nullptr));
+    if (!mem) [[unlikely]] return std::unexpected(mem.error());
+
+    std::scoped_lock lock{_mutex};
+
+    ++_stats.allocations;
+    ++_stats.dedicated;
+    _track(bytes, bytes);
+
+    return arena_buffer{this, *std::move(mem), bytes, _dedicated_class};
+  }
+
+  // Under the lock
+  auto _track(std::size_t size, std::size_t requested) noexcept -> void
+  {
+    ++_live;
+    _stats.in_use_bytes += size;
+    _stats.requested_bytes += requested;
+    _stats.high_water_bytes = std::max(_stats.high_water_bytes, _stats.in_use_bytes);
+  }
+
+  auto _release(std::size_t size, std::size_t requested) noexcept -> void
+  {
+    std::scoped_lock lock{_mutex};
+
+    --_live;
+    _stats.in_use_bytes -= size;
+    _stats.requested_bytes -= requested;
+  }
+
+  auto _return(mem_handle mem, std::size_t requested, unsigned cls) noexcept -> void
+  {
+    if (cls == _dedicated_class)
+    {
+      mem.reset();
+      _release(requested, requested);
+      return;
+    }
+
+    if (_options.mode == arena_mode::monotonic)
+    {
+      mem.reset();
+      _release(_aligned(requested), requested);
+      return;
+    }
+
+    std::scoped_lock lock{_mutex};
+
+    --_live;
+    _stats.in_use_bytes -= _class_bytes(cls);
+    _stats.requested_bytes -= requested;
+
+    if (cls >= _free.size()) _free.resize(cls + 1);
+    _free[cls].push_back(std::move(mem));
+  }
+
+  context_handle _ctx;
+  buffer_arena_options _options;
+  std::size_t _align = 1;
+
+  mutable std::mutex _mutex;
+
+  std::vector<mem_handle> _blocks;
+  std::size_t _block = 0;   // the block being carved
+  std::size_t _used = 0;    // of the block being carved
+
+  std::vector<std::vector<mem_handle>> _free;
+  std::size_t _live = 0;
+
+  buffer_arena_stats _stats{};
+};
+
+inline arena_buffer::~arena_buffer()
+{
+  if (_arena and _mem) _arena->_return(std::move(_mem), _size, _class);
+}
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,348 @@
+#pragma once
+
+#include "clapi/runtime/device.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/query.hh"
+#include "clapi/runtime/task.hh"
+#include "clapi/runtime/worker_pool.hh"
+
+#include <CL/cl.h>
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <expected>
+#include <format>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// build_failure, build_result - outcome of the program build
+//----------------------------------------------------------------------------------------
+//
+// The log is fetched only when build failed, for each of devices failing it.
+
+struct build_failure
+{
+  error_code_t code;
+  std::string log;
+};
+
+using build_result = std::expected<program_handle, build_failure>;
+
+} // namespace clapi::runtime
+
+namespace clapi::_detail::runtime
+{
+
+using namespace clapi::runtime;
+
+// Shared by the build operation, awaiting coroutine and the driver callback.
+struct _build_state
+{
+  program_handle program;
+  std::vector<::cl_device_id> devices;
+  std::string options;
+
+  // Runs the build, then its completion (and the resumed coroutine)
+  worker_pool *pool = nullptr;
+
+  std::optional<build_result> result;
+
+  std::atomic<bool> completed{false};
+
+  // Awaiting coroutine, or `_ready` once the result is set.
+  std::atomic<void *> waiter{nullptr};
+
+  static inline char _ready_tag;
+  static constexpr void *_ready = &_ready_tag;
+
+  // The immediate error of `clBuildProgram`, or 0 when finished by the callback
+  auto complete(::cl_int immediate = CL_SUCCESS) noexcept -> void
+  {
+    // Drivers are allowed to both report error and call back
+    if (completed.exchange(true, std::memory_order_acq_rel)) return;
+
+    result.emplace(_outcome(immediate));
+
+    if (void *w = waiter.exchange(_ready, std::memory_order_acq_rel))
+      std::coroutine_handle<>::from_address(w).resume();
+  }
+
+  // False when there is nothing to wait for (anymore)
+  auto suspend(std::coroutine_handle<> h) noexcept -> bool
+  {
+    void *expected = nullptr;
+
+    return waiter.compare_exchange_strong(expected, h.address(),
+                                          std::memory_order_acq_rel);
+  }
+
+  auto _outcome(::cl_int immediate) noexcept -> build_result
+  {
+    using namespace clapi::enable_errcode_int_compare;
+
+    try {
+      std::string log;
+
+      for (auto dev : devices)
+      {
+        ::cl_build_status status = CL_BUILD_ERROR;
+
+        if (auto r = check<::clGetProgramBuildInfo>(program.get(), dev,
+                                                    CL_PROGRAM_BUILD_STATUS,
+                                                    sizeof(status), &status, nullptr);
+            !r) [[unlikely]]
+          return std::unexpected(build_failure{r.error(), {}});
+
+        if (status == CL_BUILD_SUCCESS) [[likely]] continue;
+
+        log += std::format("--- {} ---\n", runtime::device{dev}.name());
+        log += _build_log(dev);
+      }
+
+      if (log.empty() and immediate == CL_SUCCESS) [[likely]]
+        return std::move(program);
+
+      auto code = error_code_t(immediate != CL_SUCCESS ? immediate
+                                                       : CL_BUILD_PROGRAM_FAILURE);
+
+      return std::unexpected(build_failure{code, std::move(log)});
+    }
+    catch (error_code_t e) {
+      return std::unexpected(build_failure{e, {}});
+    }
+    catch (...) {
+      // Only fetching (or formatting) the log throws, thus the build did fail
+      auto code = error_code_t(immediate != CL_SUCCESS ? immediate
+                                                       : CL_BUILD_PROGRAM_FAILURE);
+
+      return std::unexpected(build_failure{code, {}});
+    }
+  }
+
+  auto _build_log(::cl_device_id dev) -> std::string
+  {
+    std::size_t size = 0;
+
+    if (not check<::clGetProgramBuildInfo>(program.get(), dev, CL_PROGRAM_BUILD_LOG,
+                                           0, nullptr, &size))
+      return {};
+
+    std::string log(size, '\0');
+
+    if (not check<::clGetProgramBuildInfo>(program.get(), dev, CL_PROGRAM_BUILD_LOG,
+                                           size, log.data(), nullptr))
+      return {};
+
+    // Drop the terminating null
+    while (not log.empty() and log.back() == '\0') log.pop_back();
+
+    return log;
+  }
+
+  // Posts completion to the pool, no user code runs on the driver's thread
+  static auto CL_CALLBACK _notify(::cl_program, void *user_data) noexcept -> void
+  {
+    // Callback's own reference to the state, taken at the start
+    std::unique_ptr<std::shared_ptr<_build_state>> self{
+      static_cast<std::shared_ptr<_build_state> *>(user_data)};
+
+    auto &pool = *(*self)->pool;
+
+    try {
+      pool.post([state = *self] { state->complete(); });
+    }
+    catch (...) {
+      // Out of memory for the job, completed in place rather than never
+      (*self)->complete();
+    }
+  }
+
+  // Starts the build, reports completion either by the callback or immediately.
+  static auto start(std::shared_ptr<_build_state> state) noexcept -> void
+  {
+    using namespace clapi::enable_errcode_int_compare;
+    using clapi::ExpectedFailure;
+
+    auto *callback_ref = new std::shared_ptr<_build_state>(state);
+
+    auto r = check<::clBuildProgram>(ExpectedFailure,
+                                     state->program.get(),
+                                     ::cl_uint(state->devices.size()),
+                                     state->devices.data(),
+                                     state->options.c_str(),
+                                     _notify,
+                                     callback_ref);
+    if (r) [[likely]] return;
+
+    // The build did not even start, there will be no callback.
+    if (r.error() != CL_BUILD_PROGRAM_FAILURE)
+      delete callback_ref;
+
+    state->complete(::cl_int(r.error()));
+  }
+};
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// build_operation - the program build running in background, awaitable once
+//----------------------------------------------------------------------------------------
+//
+// Build starts at construction, on a thread of the pool, so even drivers building
+// synchronously despite `pfn_notify` build many programs at once. The driver's callback
+// just posts completion to the pool, thus the awaiting coroutine is resumed on one of
+// its threads.
+//
+// Note: When driver refuses build with `CL_BUILD_PROGRAM_FAILURE` at once, {{{
+//       it may still call back or not. The callback's reference to the (small)
+//       shared state is leaked then, rather than risking use after free.
+//
+//       The pool must outlive the build, its callback posts to it.
+// }}}
+
+class [[nodiscard]] build_operation
+{
+  using _state_t = _detail::runtime::_build_state;
+
+public:
+  build_operation(worker_pool &pool,
+                  program_handle program,
+                  std::span<const ::cl_device_id> devices,
+                  std::string_view options = {}) :
+    _state(std::make_shared<_state_t>())
+  {
+    _state->program = std::move(program);
+    _state->devices.assign(devices.begin(), devices.end());
+    _state->options = options;
+    _state->pool = &pool;
+
+    pool.post([state = _state] { _state_t::start(state); });
+  }
+
+  auto operator co_await() && noexcept
+  {
+    struct awaiter
+    {
+      std::shared_ptr<_state_t> state;
+
+      auto await_ready() const noexcept -> bool
+      {
+        return state->waiter.load(std::memory_order_acquire) == _state_t::_ready;
+      }
+
+      auto await_suspend(std::coroutine_handle<> h) noexcept -> bool
+      {
+        return state->suspend(h);
+      }
+
+      auto await_resume() -> build_result { return *std::move(state->result); }
+    };
+
+    return awaiter{_state};
+  }
+
+private:
+  std::shared_ptr<_state_t> _state;
+};
+
+[[nodiscard]]
+inline auto build_async(worker_pool &pool,
+                        program_handle program,
+                        std::span<const ::cl_device_id> devices,
+                        std::string_view options = {}) -> build_operation
+{
+  return build_operation{pool, std::move(program), devices, options};
+}
+
+} // namespace clapi::runtime
+
+namespace clapi::_detail::runtime
+{
+
+// Parameters are owned by the coroutine frame, the task starts only once awaited
+inline auto _build_all(worker_pool &pool,
+                       ::cl_context ctx,
+                       std::vector<std::string> sources,
+                       std::vector<::cl_device_id> devices,
+                       std::string options) -> task<std::vector<build_result>>
+{
+  std::vector<std::expected<build_operation, error_code_t>> started;
+  std::vector<build_result> results;
+
+  started.reserve(sources.size());
+  results.reserve(sources.size());
+
+  for (const auto &source : sources)
+  {
+    const char *text = source.data();
+    const std::size_t size = source.size();
+
+    auto program = adopt(check<::clCreateProgramWithSource>(ctx, 1, &text, &size));
+
+    if (program) [[likely]]
+      started.emplace_back(std::in_place, pool, std::move(*program), devices, options);
+    else
+      started.emplace_back(std::unexpect, program.error());
+  }
+
+  for (auto &op : started)
+  {
+    if (op) [[likely]]
+      results.push_back(co_await std::move(*op));
+    else
+      results.push_back(std::unexpected(build_failure{op.error(), {}}));
+  }
+
+  co_return results;
+}
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// build_all - builds N programs (from the source) for M devices, all at once
+//----------------------------------------------------------------------------------------
+//
+// Results are in order of sources. Takes as long as the slowest of builds, rather than
+// the sum of all of them. Failure to create program fails just its own result.
+//
+// Note: The pool is the caller's, since the task may finish on one of its {{{
+//       threads, which could not join itself then.
+//
+//       Sources, devices and options are copied before the (lazy) task is returned,
+//       so those may be temporaries of the call.
+// }}}
+
+[[nodiscard]]
+inline auto build_all(worker_pool &pool,
+                      ::cl_context ctx,
+                      std::span<const std::string_view> sources,
+                      std::span<const ::cl_device_id> devices,
+                      std::string_view options = {}) -> task<std::vector<build_result>>
+{
+  return _detail::runtime::_build_all(pool, ctx,
+                                      std::vector<std::string>(sources.begin(),
+                                                               sources.end()),
+                                      std::vector(devices.begin(), devices.end()),
+                                      std::string{options});
+}
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
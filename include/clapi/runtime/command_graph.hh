@@ -0,0 +1,220 @@
+#pragma once
+
+#include "clapi/runtime/device.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+// Enqueues the command to the queue, waiting for the events, with event of its completion
+using enqueue_op = std::move_only_function<
+  error_or<>(::cl_command_queue, std::span<const ::cl_event>, ::cl_event *)>;
+
+using graph_node = std::size_t;
+
+//----------------------------------------------------------------------------------------
+// graph_queues - queues the graph runs on
+//----------------------------------------------------------------------------------------
+//
+// Single out-of-order queue when the device supports it, several in-order queues
+// otherwise, so independent nodes overlap either way.
+
+struct graph_queues
+{
+  std::vector<queue_handle> queues;
+  bool out_of_order;
+};
+
+[[nodiscard]]
+inline auto supports_out_of_order(::cl_device_id dev) -> bool
+{
+  const auto props = runtime::device{dev}.queue_on_host_properties();
+
+  return props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+}
+
+[[nodiscard]]
+inline auto make_graph_queues(::cl_context ctx,
+                              ::cl_device_id dev,
+                              unsigned in_order_queues = 4) -> error_or<graph_queues>
+{
+  graph_queues result{.queues = {}, .out_of_order = supports_out_of_order(dev)};
+
+  const ::cl_queue_properties ooo[] = {
+    CL_QUEUE_PROPERTIES, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE,
+    0
+  };
+
+  const unsigned n = result.out_of_order ? 1u : std::max(1u, in_order_queues);
+
+  for (unsigned i = 0; i < n; ++i)
+  {
+    auto q = adopt(check<::clCreateCommandQueueWithProperties>(
+      ctx, dev, result.out_of_order ? ooo : nullptr));
+
+    if (!q) [[unlikely]] return std::unexpected(q.error());
+
+    result.queues.push_back(*std::move(q));
+  }
+
+  return result;
+}
+
+//----------------------------------------------------------------------------------------
+// graph_run - events of the enqueued graph, by node
+//----------------------------------------------------------------------------------------
+
+struct graph_run
+{
+  std::vector<event_handle> events;
+
+  [[nodiscard]]
+  auto event_of(graph_node n) const noexcept -> ::cl_event { return events[n].get(); }
+
+  // Blocks until all of the nodes completed
+  auto wait() const -> error_or<>
+  {
+    std::vector<::cl_event> raw;
+    raw.reserve(events.size());
+
+    for (const auto &e : events) raw.push_back(e.get());
+
+    if (raw.empty()) return {};
+
+    return check<::clWaitForEvents>(::cl_uint(raw.size()), raw.data());
+  }
+};
+
+//----------------------------------------------------------------------------------------
+// command_graph - DAG of enqueue operations, edges become event wait lists
+//----------------------------------------------------------------------------------------
+//
+// Nodes may depend only on nodes added before, thus graph is acyclic by construction
+// and enqueued in order of the nodes.
+//
+// ``` c++
+// command_graph g;
+//
+// auto up    = g.add(upload);
+// auto left  = g.add(blur, {up});
+// auto right = g.add(edges, {up});
+// auto join  = g.add(blend, {left, right});
+// g.add(readback, {join});
+//
+// auto run = g.run(*make_graph_queues(ctx, dev));
+// ```
+//
+// Note: Spread over in-order queues, node continues the queue of its {{{
+//       dependency when that was the last one enqueued there (no event needed then),
+//       otherwise takes the next queue in round-robin. Dependencies already ordered
+//       by the in-order queue are left out of the wait list.
+//
+//       The graph can be run many times, operations are invoked on every run.
+// }}}
+
+class command_graph
+{
+public:
+  auto add(enqueue_op op, std::initializer_list<graph_node> after = {}) -> graph_node
+  {
+    return add(std::move(op), std::span{after.begin(), after.size()});
+  }
+
+  auto add(enqueue_op op, std::span<const graph_node> after) -> graph_node
+  {
+    const graph_node n = _nodes.size();
+
+    if (std::ranges::any_of(after, [n] (graph_node d) { return d >= n; })) [[unlikely]]
+      throw error_code_t(CL_INVALID_VALUE);
+
+    _nodes.push_back({std::move(op), {after.begin(), after.end()}});
+    return n;
+  }
+
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t { return _nodes.size(); }
+
+  [[nodiscard]]
+  auto run(const graph_queues &on) -> error_or<graph_run>
+  {
+    const std::size_t nqueues = on.queues.size();
+
+    if (nqueues == 0) [[unlikely]] return to_error(CL_INVALID_COMMAND_QUEUE);
+
+    constexpr graph_node none = graph_node(-1);
+
+    graph_run result;
+    result.events.reserve(_nodes.size());
+
+    std::vector<std::size_t> queue_of(_nodes.size());
+    std::vector<graph_node> tail(nqueues, none);
+    std::vector<::cl_event> wait;
+    std::size_t next = 0;
+
+    for (graph_node n = 0; n < _nodes.size(); ++n)
+    {
+      auto &node = _nodes[n];
+      std::size_t q = 0;
+
+      if (not on.out_of_order)
+      {
+        auto chained = std::ranges::find_if(node.after, [&] (graph_node d) {
+          return tail[queue_of[d]] == d;
+        });
+
+        q = chained != node.after.end() ? queue_of[*chained] : next++ % nqueues;
+      }
+
+      wait.clear();
+
+      for (auto d : node.after)
+        if (on.out_of_order or queue_of[d] != q)
+          wait.push_back(result.events[d].get());
+
+      ::cl_event done = nullptr;
+
+      if (auto r = node.op(on.queues[q].get(), wait, &done); !r) [[unlikely]]
+        return std::unexpected(r.error());
+
+      // Dependents could not wait for it, nor `graph_run::wait()`
+      if (done == nullptr) [[unlikely]] return to_error(CL_INVALID_EVENT);
+
+      result.events.emplace_back(done);
+      queue_of[n] = q;
+      tail[q] = n;
+    }
+
+    // Waits across queues need commands of the other queue submitted
+    for (const auto &q : on.queues)
+      if (auto r = check<::clFlush>(q.get()); !r) [[unlikely]]
+        return std::unexpected(r.error());
+
+    return result;
+  }
+
+private:
+  struct _node
+  {
+    enqueue_op op;
+    std::vector<graph_node> after;
+  };
+
+  std::vector<_node> _nodes;
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,460 @@
+#pragma once
+
+#include "clapi/etc/seq.hh"
+#include "clapi/runtime/enumerate.hh"
+#include "clapi/runtime/intern.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+#include <CL/cl_ext.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// device_prop, platform_prop - memoized properties of `device` and `platform` proxies
+//----------------------------------------------------------------------------------------
+
+enum struct device_prop : unsigned
+{
+  type,
+  platform,
+  available,
+  name,
+  vendor,
+  version,
+  driver_version,
+  profile,
+  numeric_version,
+  extensions,
+  max_compute_units,
+  max_clock_frequency,
+  global_mem_size,
+  local_mem_size,
+  max_mem_alloc_size,
+  max_work_group_size,
+  mem_base_addr_align,
+  host_unified_memory,
+  double_fp_config,
+  half_fp_config,
+  queue_on_host_properties,
+  svm_capabilities,
+
+  _count
+};
+
+enum struct platform_prop : unsigned
+{
+  name,
+  vendor,
+  version,
+  profile,
+  numeric_version,
+
+  _count
+};
+
+} // namespace clapi::runtime
+
+namespace clapi::_detail::runtime
+{
+
+using namespace clapi::runtime;
+
+//----------------------------------------------------------------------------------------
+// _scalar_prop, _interned_prop, _fallible_prop - how the property is fetched and kept
+//----------------------------------------------------------------------------------------
+
+template <auto Fn_, typename Ty_, auto Info_>
+struct _scalar_prop
+{
+  using type = Ty_;
+
+  static auto fetch(auto id) -> type
+  {
+    Ty_ value;
+
+    if (auto r = check<Fn_>(id, Info_, sizeof(value), &value, nullptr); !r) [[unlikely]]
+      throw r.error();
+
+    return value;
+  }
+};
+
+template <auto Fn_, auto Info_>
+struct _interned_prop
+{
+  using type = interned;
+
+  static auto fetch(auto id) -> type
+  {
+    return query_interned_property_<Fn_>(id, Info_);
+  }
+};
+
+// Properties which are legitimately missing on older platforms, or without extension.
+// The failure is memoized as well, without being logged.
+template <auto Fn_, typename Ty_, auto Info_>
+struct _fallible_prop
+{
+  using type = error_or<Ty_>;
+
+  static auto fetch(auto id) noexcept -> type
+  {
+    Ty_ value;
+
+    if (auto r = check<Fn_>(ExpectedFailure, id, Info_, sizeof(value), &value, nullptr);
+        !r)
+      return std::unexpected{r.error()};
+
+    return value;
+  }
+};
+
+template <device_prop> struct _device_prop;
+template <platform_prop> struct _platform_prop;
+
+#define _clapi_DEVICE_PROP(Prop_, Kind_, ...) \
+  template <> struct _device_prop<device_prop::Prop_> : \
+    Kind_<::clGetDeviceInfo __VA_OPT__(,) __VA_ARGS__> {}
+
+_clapi_DEVICE_PROP(type, _scalar_prop, ::cl_device_type, CL_DEVICE_TYPE);
+_clapi_DEVICE_PROP(platform, _scalar_prop, ::cl_platform_id, CL_DEVICE_PLATFORM);
+_clapi_DEVICE_PROP(available, _scalar_prop, ::cl_bool, CL_DEVICE_AVAILABLE);
+_clapi_DEVICE_PROP(name, _interned_prop, CL_DEVICE_NAME);
+_clapi_DEVICE_PROP(vendor, _interned_prop, CL_DEVICE_VENDOR);
+_clapi_DEVICE_PROP(version, _interned_prop, CL_DEVICE_VERSION);
+_clapi_DEVICE_PROP(driver_version, _interned_prop, CL_DRIVER_VERSION);
+_clapi_DEVICE_PROP(profile, _interned_prop, CL_DEVICE_PROFILE);
+_clapi_DEVICE_PROP(numeric_version, _fallible_prop, ::cl_version, CL_DEVICE_NUMERIC_VERSION);
+_clapi_DEVICE_PROP(extensions, _interned_prop, CL_DEVICE_EXTENSIONS);
+_clapi_DEVICE_PROP(max_compute_units, _scalar_prop, ::cl_uint, CL_DEVICE_MAX_COMPUTE_UNITS);
+_clapi_DEVICE_PROP(max_clock_frequency, _scalar_prop, ::cl_uint, CL_DEVICE_MAX_CLOCK_FREQUENCY);
+_clapi_DEVICE_PROP(global_mem_size, _scalar_prop, ::cl_ulong, CL_DEVICE_GLOBAL_MEM_SIZE);
+_clapi_DEVICE_PROP(local_mem_size, _scalar_prop, ::cl_ulong, CL_DEVICE_LOCAL_MEM_SIZE);
+_clapi_DEVICE_PROP(max_mem_alloc_size, _scalar_prop, ::cl_ulong, CL_DEVICE_MAX_MEM_ALLOC_SIZE);
+_clapi_DEVICE_PROP(max_work_group_size, _scalar_prop, ::size_t, CL_DEVICE_MAX_WORK_GROUP_SIZE);
+_clapi_DEVICE_PROP(mem_base_addr_align, _scalar_prop, ::cl_uint, CL_DEVICE_MEM_BASE_ADDR_ALIGN);
+_clapi_DEVICE_PROP(host_unified_memory, _scalar_prop, ::cl_bool, CL_DEVICE_HOST_UNIFIED_MEMORY);
+_clapi_DEVICE_PROP(double_fp_config, _scalar_prop, ::cl_device_fp_config, CL_DEVICE_DOUBLE_FP_CONFIG);
+_clapi_DEVICE_PROP(half_fp_config, _fallible_prop, ::cl_device_fp_config, CL_DEVICE_HALF_FP_CONFIG);
+_clapi_DEVICE_PROP(queue_on_host_properties, _scalar_prop, ::cl_command_queue_properties,
+                   CL_DEVICE_QUEUE_ON_HOST_PROPERTIES);
+_clapi_DEVICE_PROP(svm_capabilities, _fallible_prop, ::cl_device_svm_capabilities,
+                   CL_DEVICE_SVM_CAPABILITIES);
+
+#undef _clapi_DEVICE_PROP
+
+#define _clapi_PLATFORM_PROP(Prop_, Kind_, ...) \
+  template <> struct _platform_prop<platform_prop::Prop_> : \
+    Kind_<::clGetPlatformInfo __VA_OPT__(,) __VA_ARGS__> {}
+
+_clapi_PLATFORM_PROP(name, _interned_prop, CL_PLATFORM_NAME);
+_clapi_PLATFORM_PROP(vendor, _interned_prop, CL_PLATFORM_VENDOR);
+_clapi_PLATFORM_PROP(version, _interned_prop, CL_PLATFORM_VERSION);
+_clapi_PLATFORM_PROP(profile, _interned_prop, CL_PLATFORM_PROFILE);
+_clapi_PLATFORM_PROP(numeric_version, _fallible_prop, ::cl_version, CL_PLATFORM_NUMERIC_VERSION);
+
+#undef _clapi_PLATFORM_PROP
+
+//----------------------------------------------------------------------------------------
+// _memo_cache - lazily filled per-object cache of all `Prop_` enumerated properties
+//----------------------------------------------------------------------------------------
+//
+// Note: Each property is fetched at most once (successfully) for lifetime of cache. {{{
+//       Reads of already fetched properties take no locks, first fetch serializes on
+//       the per-object mutex, thus different objects can be queried concurrently.
+// }}}
+
+template <typename Prop_,
+          template <Prop_> class Traits_,
+          typename Id_,
+          typename = iseq_for_n<std::to_underlying(Prop_::_count)>>
+class _memo_cache;
+
+template <typename Prop_,
+          template <Prop_> class Traits_,
+          typename Id_,
+          std::size_t... Props_>
+class _memo_cache<Prop_, Traits_, Id_, iseq<Props_...>>
+{
+  static_assert(sizeof...(Props_) <= 64, "fetched properties won't fit the bitmask");
+
+  using mask_t = std::uint64_t;
+
+  template <Prop_ P_>
+  static constexpr mask_t _bit = mask_t(1) << std::to_underlying(P_);
+
+public:
+  using id_t = Id_;
+
+  template <Prop_ P_>
+  using value_t = typename Traits_<P_>::type;
+
+  explicit _memo_cache(id_t id) noexcept : _id(id) {}
+
+  [[nodiscard]]
+  auto id() const noexcept -> id_t { return _id; }
+
+  template <Prop_ P_>
+  [[nodiscard]]
+  auto get() -> const value_t<P_> &
+  {
+    if (_fetched.load(std::memory_order_acquire) & _bit<P_>) [[likely]]
+      return std::get<std::to_underlying(P_)>(_values);
+
+    std::scoped_lock lock{_fill};
+
+    if (not (_fetched.load(std::memory_order_relaxed) & _bit<P_>))
+    {
+      std::get<std::to_underlying(P_)>(_values) = Traits_<P_>::fetch(_id);
+      _fetched.fetch_or(_bit<P_>, std::memory_order_release);
+    }
+
+    return std::get<std::to_underlying(P_)>(_values);
+  }
+
+  // Remembers already known value, sparing the driver round trip.
+  template <Prop_ P_>
+  auto seed(value_t<P_> value) -> void
+  {
+    if (_fetched.load(std::memory_order_acquire) & _bit<P_>) return;
+
+    std::scoped_lock lock{_fill};
+
+    if (not (_fetched.load(std::memory_order_relaxed) & _bit<P_>))
+    {
+      std::get<std::to_underlying(P_)>(_values) = std::move(value);
+      _fetched.fetch_or(_bit<P_>, std::memory_order_release);
+    }
+  }
+
+private:
+  id_t _id;
+  std::atomic<mask_t> _fetched{0};
+  std::mutex _fill;
+
+  std::tuple<value_t<Prop_(Props_)>...> _values{};
+};
+
+using _device_cache = _memo_cache<device_prop, _device_prop, ::cl_device_id>;
+using _platform_cache = _memo_cache<platform_prop, _platform_prop, ::cl_platform_id>;
+
+//----------------------------------------------------------------------------------------
+// _cache_of - process-wide, never shrinking, cache of given OpenCL object
+//----------------------------------------------------------------------------------------
+
+template <typename Cache_>
+[[nodiscard]]
+auto _cache_of(typename Cache_::id_t id) -> Cache_ *
+{
+  static std::shared_mutex mutex;
+  static std::unordered_map<typename Cache_::id_t, std::unique_ptr<Cache_>> caches;
+
+  {
+    std::shared_lock lock{mutex};
+
+    if (auto it = caches.find(id); it != caches.end()) [[likely]]
+      return it->second.get();
+  }
+
+  std::scoped_lock lock{mutex};
+
+  auto [it, _] = caches.try_emplace(id, nullptr);
+  if (not it->second) it->second = std::make_unique<Cache_>(id);
+
+  return it->second.get();
+}
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// platform - pointer-sized proxy of `cl_platform_id` memoizing its properties
+//----------------------------------------------------------------------------------------
+
+class platform
+{
+  using _cache_t = _detail::runtime::_platform_cache;
+
+public:
+  explicit platform(::cl_platform_id id) :
+    _cache(_detail::runtime::_cache_of<_cache_t>(id)) {}
+
+  [[nodiscard]]
+  auto id() const noexcept -> ::cl_platform_id { return _cache->id(); }
+
+  template <platform_prop P_>
+  [[nodiscard]]
+  auto get() const -> const _cache_t::value_t<P_> & { return _cache->get<P_>(); }
+
+  [[nodiscard]]
+  auto name() const -> interned { return get<platform_prop::name>(); }
+
+  [[nodiscard]]
+  auto vendor() const -> interned { return get<platform_prop::vendor>(); }
+
+  [[nodiscard]]
+  auto version() const -> interned { return get<platform_prop::version>(); }
+
+  [[nodiscard]]
+  auto profile() const -> interned { return get<platform_prop::profile>(); }
+
+  // Fails on platforms older than OpenCL 3.0 (w/o cl_khr_extended_versioning)
+  [[nodiscard]]
+  auto numeric_version() const -> error_or<::cl_version>
+  {
+    return get<platform_prop::numeric_version>();
+  }
+
+  friend auto operator==(platform, platform) noexcept -> bool = default;
+
+private:
+  _cache_t *_cache;
+};
+
+//----------------------------------------------------------------------------------------
+// device - pointer-sized proxy of `cl_device_id` memoizing its properties
+//----------------------------------------------------------------------------------------
+//
+// Any copy of the device proxy shares the same process-wide cache, thus the driver is
+// asked for each of properties at most once per device.
+//
+// Note: Meant for root devices, which are never released. {{{
+//       Released sub-device ids might get reused by the driver.
+// }}}
+
+class device
+{
+  using _cache_t = _detail::runtime::_device_cache;
+
+public:
+  explicit device(::cl_device_id id) :
+    _cache(_detail::runtime::_cache_of<_cache_t>(id)) {}
+
+  // The enumeration already knows the platform, that is remembered. Its type is just
+  // the filter of the enumeration (eg. `CL_DEVICE_TYPE_ALL`), the real one is queried.
+  explicit device(const full_device_id_t &full_id) :
+    device(std::get<::cl_device_id>(full_id))
+  {
+    _cache->seed<device_prop::platform>(std::get<::cl_platform_id>(full_id));
+  }
+
+  [[nodiscard]]
+  auto id() const noexcept -> ::cl_device_id { return _cache->id(); }
+
+  [[nodiscard]]
+  auto full_id() const -> full_device_id_t
+  {
+    return {platform_id(), id(), type()};
+  }
+
+  template <device_prop P_>
+  [[nodiscard]]
+  auto get() const -> const _cache_t::value_t<P_> & { return _cache->get<P_>(); }
+
+  [[nodiscard]]
+  auto type() const -> ::cl_device_type { return get<device_prop::type>(); }
+
+  [[nodiscard]]
+  auto platform_id() const -> ::cl_platform_id { return get<device_prop::platform>(); }
+
+  [[nodiscard]]
+  auto platform() const -> runtime::platform { return runtime::platform{platform_id()}; }
+
+  [[nodiscard]]
+  auto available() const -> bool { return get<device_prop::available>(); }
+
+  [[nodiscard]]
+  auto name() const -> interned { return get<device_prop::name>(); }
+
+  [[nodiscard]]
+  auto vendor() const -> interned { return get<device_prop::vendor>(); }
+
+  [[nodiscard]]
+  auto version() const -> interned { return get<device_prop::version>(); }
+
+  [[nodiscard]]
+  auto driver_version() const -> interned { return get<device_prop::driver_version>(); }
+
+  [[nodiscard]]
+  auto profile() const -> interned { return get<device_prop::profile>(); }
+
+  // Fails on devices older than OpenCL 3.0 (w/o cl_khr_extended_versioning)
+  [[nodiscard]]
+  auto numeric_version() const -> error_or<::cl_version>
+  {
+    return get<device_prop::numeric_version>();
+  }
+
+  [[nodiscard]]
+  auto compute_units() const -> ::cl_uint { return get<device_prop::max_compute_units>(); }
+
+  // In MHz
+  [[nodiscard]]
+  auto max_clock() const -> ::cl_uint { return get<device_prop::max_clock_frequency>(); }
+
+  [[nodiscard]]
+  auto global_mem_size() const -> ::cl_ulong { return get<device_prop::global_mem_size>(); }
+
+  [[nodiscard]]
+  auto host_unified_memory() const -> bool
+  {
+    return get<device_prop::host_unified_memory>();
+  }
+
+  // In bytes, (CL_DEVICE_MEM_BASE_ADDR_ALIGN is reported in bits)
+  [[nodiscard]]
+  auto mem_base_addr_align() const -> std::size_t
+  {
+    return get<device_prop::mem_base_addr_align>() / 8;
+  }
+
+  [[nodiscard]]
+  auto queue_on_host_properties() const -> ::cl_command_queue_properties
+  {
+    return get<device_prop::queue_on_host_properties>();
+  }
+
+  // Fails on devices older than OpenCL 2.0
+  [[nodiscard]]
+  auto svm_capabilities() const -> error_or<::cl_device_svm_capabilities>
+  {
+    return get<device_prop::svm_capabilities>();
+  }
+
+  [[nodiscard]]
+  auto has_fp64() const -> bool { return get<device_prop::double_fp_config>() != 0; }
+
+  [[nodiscard]]
+  auto has_fp16() const -> bool
+  {
+    const auto &config = get<device_prop::half_fp_config>();
+    return config.has_value() and *config != 0;
+  }
+
+  friend auto operator==(device, device) noexcept -> bool = default;
+
+private:
+  _cache_t *_cache;
+};
+
+static_assert(sizeof(device) == sizeof(void *));
+static_assert(sizeof(platform) == sizeof(void *));
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
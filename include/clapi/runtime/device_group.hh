@@ -0,0 +1,218 @@
+#pragma once
+
+#include "clapi/runtime/device.hh"
+#include "clapi/runtime/enumerate.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/probe.hh"
+#include "clapi/runtime/query.hh"
+#include "clapi/runtime/worker_pool.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <expected>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+struct device_group_options
+{
+  unsigned queues_per_device = 1;
+  ::cl_command_queue_properties queue_properties = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// device_group - contexts and queues of the selected set of devices
+//----------------------------------------------------------------------------------------
+//
+// One context per platform, covering all of that platform's devices of the group,
+// and `queues_per_device` queues per each device. Members keep the order of devices
+// given at the construction.
+//
+// The group owns all of contexts and queues (by `handle`s) and releases them
+// on destruction. It is move-only.
+//
+// Note: Contexts are created in parallel, then queues are, for all of devices {{{
+//       at once. When anything fails, whatever was created is released and
+//       the first failure (`clapi::error_code_t`) is thrown.
+// }}}
+
+class device_group
+{
+public:
+  struct platform_context
+  {
+    ::cl_platform_id platform;
+    context_handle context;
+  };
+
+  struct member
+  {
+    runtime::device device;
+    ::cl_context context;  // owned by the platform_context
+    std::vector<queue_handle> queues;
+  };
+
+  device_group() noexcept = default;
+
+  explicit device_group(std::span<const device> devices, device_group_options options = {})
+  {
+    if (devices.empty()) return;
+
+    worker_pool pool{unsigned(std::min<std::size_t>(devices.size(),
+                                                    worker_pool::default_concurrency()))};
+
+    _create_contexts(pool, devices);
+    _create_queues(pool, devices, options);
+  }
+
+  template <std::ranges::input_range Range_>
+    requires std::convertible_to<std::ranges::range_reference_t<Range_>,
+                                 const full_device_id_t &>
+  explicit device_group(Range_ &&full_ids, device_group_options options = {}) :
+    device_group(std::forward<Range_>(full_ids)
+                 | std::views::transform([] (const full_device_id_t &id) static {
+                     return device{id};
+                   })
+                 | std::ranges::to<std::vector>(),
+                 options)
+  {}
+
+  device_group(device_group &&) noexcept = default;
+  auto operator=(device_group &&) noexcept -> device_group & = default;
+
+  [[nodiscard]]
+  auto contexts() const noexcept -> std::span<const platform_context> { return _contexts; }
+
+  [[nodiscard]]
+  auto members() const noexcept -> std::span<const member> { return _members; }
+
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t { return _members.size(); }
+
+  [[nodiscard]]
+  auto empty() const noexcept -> bool { return _members.empty(); }
+
+  [[nodiscard]]
+  auto operator[](std::size_t i) const noexcept -> const member & { return _members[i]; }
+
+  // The context of the platform, nullptr if none of group's devices is of it
+  [[nodiscard]]
+  auto context_of(::cl_platform_id platform) const noexcept -> ::cl_context
+  {
+    auto it = std::ranges::find(_contexts, platform, &platform_context::platform);
+
+    return it != _contexts.end() ? it->context.get() : nullptr;
+  }
+
+  [[nodiscard]]
+  auto queue(std::size_t member, std::size_t n = 0) const noexcept -> ::cl_command_queue
+  {
+    return _members[member].queues[n].get();
+  }
+
+private:
+  auto _create_contexts(worker_pool &pool, std::span<const device> devices) -> void
+  {
+    using platform_devices_t = std::pair<::cl_platform_id, std::vector<::cl_device_id>>;
+
+    // Platforms in order of the first of theirs devices
+    std::vector<platform_devices_t> platforms;
+
+    for (const auto &dev : devices)
+    {
+      auto pid = dev.platform_id();
+      auto it = std::ranges::find(platforms, pid, &platform_devices_t::first);
+
+      if (it == platforms.end())
+      {
+        platforms.emplace_back(pid, std::vector<::cl_device_id>{});
+        it = std::prev(platforms.end());
+      }
+
+      it->second.push_back(dev.id());
+    }
+
+    auto create_context = [] (const platform_devices_t &p) static
+      -> error_or<context_handle>
+    {
+      const ::cl_context_properties properties[] = {
+        CL_CONTEXT_PLATFORM, ::cl_context_properties(p.first),
+        0
+      };
+
+      return adopt(check<::clCreateContext>(properties, ::cl_uint(p.second.size()),
+                                            p.second.data(), nullptr, nullptr));
+    };
+
+    auto created = probe(pool, platforms, create_context);
+
+    _throw_on_failure(created);
+
+    for (auto &&[p, ctx] : std::views::zip(platforms, created))
+      _contexts.push_back({p.first, *std::move(ctx)});
+  }
+
+  auto _create_queues(worker_pool &pool,
+                      std::span<const device> devices,
+                      const device_group_options &options) -> void
+  {
+    using queues_or_t = error_or<std::vector<queue_handle>>;
+
+    const ::cl_queue_properties properties[] = {
+      CL_QUEUE_PROPERTIES, ::cl_queue_properties(options.queue_properties),
+      0
+    };
+
+    const bool has_properties = options.queue_properties != 0;
+
+    auto create_queues = [&] (const device &dev) -> queues_or_t {
+      auto ctx = context_of(dev.platform_id());
+
+      std::vector<queue_handle> queues;
+
+      for (unsigned n = 0; n < std::max(1u, options.queues_per_device); ++n)
+      {
+        auto q = adopt(check<::clCreateCommandQueueWithProperties>(
+          ctx, dev.id(), has_properties ? properties : nullptr));
+
+        if (not q) [[unlikely]] return std::unexpected(q.error());
+
+        queues.push_back(*std::move(q));
+      }
+
+      return queues;
+    };
+
+    auto created = probe(pool, devices, create_queues);
+
+    _throw_on_failure(created);
+
+    for (auto &&[dev, queues] : std::views::zip(devices, created))
+      _members.push_back({dev, context_of(dev.platform_id()), *std::move(queues)});
+  }
+
+  // Throws the first error of `results`, if any
+  static auto _throw_on_failure(const auto &results) -> void
+  {
+    auto failed = std::ranges::find_if(results, [] (const auto &r) { return not r; });
+
+    if (failed != std::ranges::end(results)) [[unlikely]]
+      throw failed->error();
+  }
+
+  std::vector<platform_context> _contexts;
+  std::vector<member> _members;
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "clapi/etc/basic.hh"
+#include "clapi/runtime/enumerate.hh"
+
+#include <CL/cl.h>
+
+#include <chrono>
+#include <future>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// discovery_metrics - how long the driver (ICD) loading and the enumeration took
+//----------------------------------------------------------------------------------------
+//
+// All durations are measured from start of discovery.
+
+struct discovery_metrics
+{
+  using duration_t = std::chrono::steady_clock::duration;
+
+  // Includes loading of ICDs, done by the first call to `clGetPlatformIDs`
+  duration_t time_to_platforms{};
+
+  // Empty when no devices were found at all
+  std::optional<duration_t> time_to_first_device;
+
+  duration_t total{};
+};
+
+struct discovery_result
+{
+  std::vector<::cl_platform_id> platforms;
+  std::vector<full_device_id_t> devices;
+
+  discovery_metrics metrics;
+
+  // Discovered devices of given type (any of type bits), in the discovery order
+  [[nodiscard]]
+  auto devices_of(::cl_device_type type) const
+  {
+    return devices | std::views::filter([type] (const full_device_id_t &d) {
+      return (std::get<::cl_device_type>(d) & type) != 0;
+    });
+  }
+};
+
+//----------------------------------------------------------------------------------------
+// discovery_service - enumerates platforms and devices on the background thread
+//----------------------------------------------------------------------------------------
+//
+// Discovery starts at construction, thus the service is meant to be created as early
+// as possible, so the rest of initialization overlaps with loading of drivers.
+//
+// Note: The result is published through the `std::shared_future`. {{{
+//       Any error of enumeration (`clapi::error_code_t`) is rethrown from `get()`.
+//
+//       Destruction waits for discovery to finish.
+// }}}
+
+class discovery_service : immovable<discovery_service>
+{
+public:
+  explicit discovery_service(::cl_device_type type = CL_DEVICE_TYPE_ALL) :
+    _result(std::async(std::launch::async, _discover, type).share())
+  {}
+
+  [[nodiscard]]
+  auto future() const noexcept -> std::shared_future<discovery_result>
+  {
+    return _result;
+  }
+
+  [[nodiscard]]
+  auto ready() const -> bool
+  {
+    using namespace std::chrono_literals;
+    return _result.wait_for(0s) == std::future_status::ready;
+  }
+
+  // Blocks until discovery is done
+  [[nodiscard]]
+  auto get() const -> const discovery_result & { return _result.get(); }
+
+private:
+  static auto _discover(::cl_device_type type) -> discovery_result
+  {
+    using clock_t = std::chrono::steady_clock;
+
+    discovery_result found;
+
+    const auto start = clock_t::now();
+
+    found.platforms.resize(count_platforms());
+    found.platforms.resize(enum_platforms(found.platforms).size());
+
+    found.metrics.time_to_platforms = clock_t::now() - start;
+
+    for (auto p : found.platforms)
+    {
+      auto filled = found.devices.size();
+
+      found.devices.resize(filled + enum_platform_devices.count(p, type));
+      auto storage = std::span{found.devices}.subspan(filled);
+
+      found.devices.resize(filled + enum_platform_devices(p, storage, type).size());
+
+      if (not found.metrics.time_to_first_device and not found.devices.empty())
+        found.metrics.time_to_first_device = clock_t::now() - start;
+    }
+
+    found.metrics.total = clock_t::now() - start;
+
+    return found;
+  }
+
+  std::shared_future<discovery_result> _result;
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// cache_directory - per-user cache directory of clapi
+//----------------------------------------------------------------------------------------
+//
+// `$XDG_CACHE_HOME/clapi/<name>`, `~/.cache/clapi/<name>` when unset.
+
+[[nodiscard]]
+inline auto cache_directory(std::string_view name) -> std::filesystem::path
+{
+  namespace fs = std::filesystem;
+
+  if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg and *xdg)
+    return fs::path{xdg} / "clapi" / name;
+
+  if (const char *home = std::getenv("HOME"); home and *home)
+    return fs::path{home} / ".cache" / "clapi" / name;
+
+  return fs::temp_directory_path() / "clapi" / name;
+}
+
+//----------------------------------------------------------------------------------------
+// fnv1a - 64-bit FNV-1a hash, stable across runs and builds (unlike `std::hash`)
+//----------------------------------------------------------------------------------------
+
+struct fnv1a
+{
+  std::uint64_t value = 0xcbf29ce484222325ull;
+
+  constexpr auto update(std::span<const std::byte> bytes) noexcept -> fnv1a &
+  {
+    for (auto b : bytes) _step(b);
+    return *this;
+  }
+
+  // Length prefixed, thus ("ab", "c") and ("a", "bc") differ
+  constexpr auto update(std::string_view s) noexcept -> fnv1a &
+  {
+    using size_bytes_t = std::array<std::byte, sizeof(std::uint64_t)>;
+
+    update(std::bit_cast<size_bytes_t>(std::uint64_t(s.size())));
+
+    for (auto c : s) _step(std::byte(c));
+    return *this;
+  }
+
+private:
+  constexpr auto _step(std::byte b) noexcept -> void
+  {
+    value = (value ^ std::uint64_t(b)) * 0x100000001b3ull;
+  }
+};
+
+[[nodiscard]]
+inline auto fnv1a_hex(std::uint64_t h) -> std::string
+{
+  return std::format("{:016x}", h);
+}
+
+//----------------------------------------------------------------------------------------
+// write_file_atomically - writes whole file, or nothing at all
+//----------------------------------------------------------------------------------------
+//
+// Written to temporary file of the same directory, then renamed over, so concurrent
+// writers and readers never see torn file. Creates the directory when missing.
+
+inline auto write_file_atomically(const std::filesystem::path &path,
+                                  std::span<const std::span<const std::byte>> parts)
+  -> bool
+{
+  namespace fs = std::filesystem;
+
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+
+  if (ec) return false;
+
+  auto tmp = path;
+  tmp += std::format(".{:x}.tmp", std::random_device{}());
+
+  {
+    std::ofstream out{tmp, std::ios::binary | std::ios::trunc};
+
+    for (auto part : parts)
+      out.write(reinterpret_cast<const char *>(part.data()), std::streamsize(part.size()));
+
+    if (not out.flush())
+    {
+      fs::remove(tmp, ec);
+      return false;
+    }
+  }
+
+  fs::rename(tmp, path, ec);
+
+  if (ec) fs::remove(tmp, ec);
+
+  return not ec;
+}
+
+inline auto write_file_atomically(const std::filesystem::path &path,
+                                  std::string_view content) -> bool
+{
+  const std::span<const std::byte> parts[] = {std::as_bytes(std::span{content})};
+
+  return write_file_atomically(path, parts);
+}
+
+//----------------------------------------------------------------------------------------
+// evict_least_recently_used - trims directory of cache to the size cap
+//----------------------------------------------------------------------------------------
+//
+// Modification time is the time of last use, see `touch()`. Returns number of removed
+// files. Temporary files of writers in progress are left alone.
+
+inline auto touch(const std::filesystem::path &path) -> void
+{
+  namespace fs = std::filesystem;
+
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+}
+
+inline auto evict_least_recently_used(const std::filesystem::path &dir,
+                                      std::uintmax_t max_bytes) -> std::size_t
+{
+  namespace fs = std::filesystem;
+
+  struct entry_t
+  {
+    fs::path path;
+    std::uintmax_t size;
+    fs::file_time_type used;
+  };
+
+  std::error_code ec;
+  std::vector<entry_t> entries;
+  std::uintmax_t total = 0;
+
+  for (const auto &e : fs::directory_iterator{dir, ec})
+  {
+    if (not e.is_regular_file(ec) or e.path().extension() == ".tmp") continue;
+
+    entry_t entry{e.path(), e.file_size(ec), e.last_write_time(ec)};
+
+    if (ec) continue;
+
+    total += entry.size;
+    entries.push_back(std::move(entry));
+  }
+
+  if (total <= max_bytes) [[likely]] return 0;
+
+  std::ranges::sort(entries, {}, &entry_t::used);
+
+  std::size_t removed = 0;
+
+  for (const auto &e : entries)
+  {
+    if (total <= max_bytes) break;
+
+    if (fs::remove(e.path, ec))
+    {
+      total -= e.size;
+      ++removed;
+    }
+  }
+
+  return removed;
+}
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,492 @@
+#pragma once
+
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <coroutine>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <vector>
+#include <version>
+
+#if __has_include(<inplace_vector>)
+#include <inplace_vector>
+#endif
+
+// SCARY includes for std::generator, views::concat fallbacks for c++23 dialect
+// and missing std::generator<> in standard library
+
+// We're mixing std::ranges/std::ranges::views with ::ranges_v3 library.
+// XXX: For some reason ::ranges_v3 doesn't belive that libstdc++ ranges meet
+// some of concepts of ranges_v3.
+//
+// This is odd, thus should not be defined in library dependend manner and should
+// freely mix with eachother.
+// Those don't, thus we do little flaky dance over which one we use.
+//
+// It most likely boils down to some non-conforming differences in concept definitions
+// while also doesn't ::ranges_v3 doesn't check for existance of
+// `std::ranges::range_adaptor_closure` going its own way ignoring existance of
+// standard library.
+//
+// Also ranges_v3 generator never learned about exitance of elements_of thus - which
+// surely warrants it's implementation having status of an experimental.
+//
+// Still better than nothing, one could say.
+//
+// TODO: Open-source lx6::rgenerator implementation???
+// It's bit coupled with rest of lx6, but shouldn't be too hard to decouple or also
+// provide the rest of small building blocks.
+// Differences seem to boil down to use of some helper traits/aliases to to traits.
+
+// TODO similar incantation over <ranges> lives in command line parsing implementation.
+#if !defined(__cpp_coroutines) && defined(__cpp_lib_coroutine)
+// required for to pass (RANGES_CXX_COROUTINES > RANGES_CXX_COROUTINES_TS1)
+// XXX: no idea why ::ranges_v3 lib depends on that
+#define __cpp_coroutines __cpp_lib_coroutine
+#endif
+#if _clapi_MISSING_RANGES_CONCAT == 1
+// XXX: It _IS_ MISSING_ std::ranges::elements_of equivalent
+#include <range/v3/experimental/utility/generator.hpp>
+
+namespace clapi::runtime
+{
+template <typename Ty_>
+using generator = ::ranges::experimental::generator<Ty_>;
+
+// XXX: ranges_v3 experimental generator has no allocator support, frames are always
+// allocated on the heap, only buffers of enumeration use provided allocator.
+template <typename Ty_>
+using pmr_generator = ::ranges::experimental::generator<Ty_>;
+} // namespace clapi::runtime
+#else
+#include <generator>
+
+namespace clapi::runtime
+{
+template <typename Ty_>
+using generator = std::generator<Ty_>;
+
+// Generator which allocates its coroutine frame with given polymorphic allocator,
+// passed as leading `std::allocator_arg_t, std::pmr::polymorphic_allocator<>`
+template <typename Ty_>
+using pmr_generator = std::generator<Ty_, void, std::pmr::polymorphic_allocator<>>;
+
+using std::ranges::elements_of;
+} // namespace clapi::runtime
+#endif
+
+namespace clapi::_detail::runtime
+{
+
+using clapi::runtime::check;
+using clapi::runtime::generator;
+
+template <typename Ty_, typename Alloc_>
+using _alloc_vector =
+  std::vector<Ty_, typename std::allocator_traits<Alloc_>::template rebind_alloc<Ty_>>;
+
+// Both frame of coroutine (if `Gen_` supports that) and its buffers
+// are allocated with the `alloc`
+template <typename Gen_, typename Alloc_>
+auto _enum_platforms(std::allocator_arg_t, Alloc_ alloc) -> Gen_
+{
+  constexpr auto getPlatformIDs = check<::clGetPlatformIDs>;
+
+  ::cl_uint nplatforms;
+  if (error_or<> result = getPlatformIDs(0, nullptr, &nplatforms);
+      result.has_value()) [[likely]]
+  {
+    if (nplatforms == 0) [[unlikely]] co_return;
+
+    _alloc_vector<cl_platform_id, Alloc_> platforms(nplatforms, alloc);
+    result = getPlatformIDs(platforms.size(), platforms.data(), nullptr);
+
+    if (!result) [[unlikely]] throw result.error();
+
+    auto ids = std::ranges::views::as_rvalue(std::move(platforms));
+
+#if _clapi_MISSING_RANGES_CONCAT
+    // XXX: ranges_v3 experimental generator
+    for (auto id : std::move(ids)) { co_yield id; }
+#else
+    co_yield clapi::runtime::elements_of(std::move(ids), alloc);
+#endif
+  }
+  else
+  {
+    throw result.error();
+  }
+}
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+inline auto enum_platforms() -> generator<cl_platform_id>
+{
+  return _detail::runtime::_enum_platforms<generator<cl_platform_id>>(
+    std::allocator_arg, std::allocator<std::byte>{});
+}
+
+// As above, but frame of generator and its buffers come from the `alloc`,
+// eg. the `std::pmr::monotonic_buffer_resource` arena.
+inline auto enum_platforms(std::allocator_arg_t,
+                           std::pmr::polymorphic_allocator<> alloc) ->
+  pmr_generator<cl_platform_id>
+{
+  return _detail::runtime::_enum_platforms<pmr_generator<cl_platform_id>>(
+    std::allocator_arg, alloc);
+}
+
+// Eager, coroutine-free counterparts of `enum_platforms()`: {{{
+//
+// Those fill the caller provided storage w/o any heap allocation,
+// returning the filled prefix of it.
+//
+// Whenever storage is too small, only as many as fit are returned,
+// the `count_platforms()` tells how many there are.
+// }}}
+
+[[nodiscard]]
+inline auto count_platforms() -> std::size_t
+{
+  constexpr auto getPlatformIDs = check<::clGetPlatformIDs>;
+
+  ::cl_uint nplatforms;
+  if (error_or<> result = getPlatformIDs(0, nullptr, &nplatforms); !result) [[unlikely]]
+    throw result.error();
+
+  return nplatforms;
+}
+
+inline auto enum_platforms(std::span<cl_platform_id> storage) -> std::span<cl_platform_id>
+{
+  constexpr auto getPlatformIDs = check<::clGetPlatformIDs>;
+
+  if (storage.empty()) return storage;
+
+  ::cl_uint capacity = std::min<std::size_t>(storage.size(), UINT_MAX);
+  ::cl_uint nplatforms;
+
+  if (error_or<> result = getPlatformIDs(capacity, storage.data(), &nplatforms);
+      !result) [[unlikely]]
+    throw result.error();
+
+  return storage.first(std::min(capacity, nplatforms));
+}
+
+#if defined(__cpp_lib_inplace_vector)
+template <std::size_t N_>
+auto enum_platforms(std::inplace_vector<cl_platform_id, N_> &storage) -> void
+{
+  storage.resize(N_);
+  storage.resize(enum_platforms(std::span{storage}).size());
+}
+#endif
+
+using full_device_id_t = std::tuple<::cl_platform_id,
+                                    ::cl_device_id,
+                                    ::cl_device_type>;
+
+// The most of devices, single platform can have enumerated w/o heap allocation.
+constexpr inline std::size_t max_stack_platform_devices = 256;
+
+// Since thare are multiple templated overloads we make it callable object.
+// This allows us to bind such object, what otherwise wouldn't be possible.
+//
+// Otherwise one would need to to cast it or wrap it in lambda function.
+struct enum_platform_devices_fn
+{
+  static const enum_platform_devices_fn self;
+
+private:
+  template <typename Gen_, typename Alloc_>
+  static auto _devices(std::allocator_arg_t, Alloc_ alloc,
+                       ::cl_platform_id pid,
+                       ::cl_device_type device_type) -> Gen_
+  {
+    using namespace std::views;
+    using clapi::ExpectedFailure;
+
+    cl_uint num_dev;
+
+    static constexpr auto getDeviceIDs = check<::clGetDeviceIDs>;
+    static constexpr auto getDeviceInfo = check<::clGetDeviceInfo>;
+
+    if (error_or<> ret = getDeviceIDs(ExpectedFailure,
+                                      pid, device_type, 0, nullptr, &num_dev);
+        not ret)
+    {
+      using namespace clapi::enable_errcode_int_compare;
+      // Will return CL_DEVICE_NOT_FOUND rather than reporting num_dev as 0,
+      // whenever no devices of specified type are present.
+      //
+      // That's not really an error, stop enumeration, yielding an empty range.
+      if (ret.error() == CL_DEVICE_NOT_FOUND) co_return;
+
+      throw ret.error();
+    }
+    else
+    {
+      if (num_dev == 0) co_return;
+
+      _detail::runtime::_alloc_vector<cl_device_id, Alloc_> devs(num_dev, alloc);
+      // Fill devices
+      if (auto ret = getDeviceIDs(pid, device_type, devs.size(), devs.data(), nullptr);
+          !ret)
+        throw ret.error();
+
+      // We're asked CL_DEVICE_TYPE_ALL, thus we don't know device type,
+      // to construct full_device_id_t, and we need to query it.
+      if (device_type == CL_DEVICE_TYPE_ALL)
+      {
+        auto dev_types = devs | transform([](auto id) {
+          cl_device_type t;
+
+          if (auto ret = getDeviceInfo(id, CL_DEVICE_TYPE, sizeof(t), &t, nullptr); !ret)
+            throw ret.error();
+
+          return t;
+        });
+
+        auto pdevs = zip(repeat(pid), devs, dev_types);
+
+#if _clapi_MISSING_RANGES_CONCAT
+        for (auto pd : pdevs) { co_yield pd; }
+#else
+        co_yield elements_of(pdevs, alloc);
+#endif
+      }
+      else
+      {
+        assert(device_type != CL_DEVICE_TYPE_ALL);
+        // There's no need to query CL_DEVICE_TYPE
+        auto pdevs = zip(repeat(pid), devs, repeat(device_type));
+
+#if _clapi_MISSING_RANGES_CONCAT
+      // XXX: ranges_v3 experimental generator
+        for (auto pd : pdevs) { co_yield pd; }
+#else
+        co_yield elements_of(pdevs, alloc);
+#endif
+      }
+    }
+  }
+
+  template <typename Gen_, typename Alloc_>
+  static auto _devices_of(std::allocator_arg_t, Alloc_ alloc,
+                          std::ranges::viewable_range auto platforms,
+                          ::cl_device_type devt) -> Gen_
+  {
+    for (auto p : platforms)
+    {
+#if _clapi_MISSING_RANGES_CONCAT
+      // XXX: ranges_v3 experimental generator
+      for (auto pd : _devices<Gen_>(std::allocator_arg, alloc, p, devt)) { co_yield pd; }
+#else
+      co_yield elements_of(_devices<Gen_>(std::allocator_arg, alloc, p, devt));
+#endif
+    }
+
+    co_return;
+  }
+
+  using _default_alloc_t = std::allocator<std::byte>;
+  using _pmr_alloc_t = std::pmr::polymorphic_allocator<>;
+
+public:
+  static auto operator() (::cl_platform_id pid,
+                          ::cl_device_type device_type = CL_DEVICE_TYPE_ALL) ->
+    generator<full_device_id_t>
+  {
+    return _devices<generator<full_device_id_t>>(std::allocator_arg, _default_alloc_t{},
+                                                 pid, device_type);
+  }
+
+  static auto operator() (std::ranges::viewable_range auto platforms,
+                          cl_device_type devt = CL_DEVICE_TYPE_ALL) ->
+    generator<full_device_id_t>
+  {
+    return _devices_of<generator<full_device_id_t>>(std::allocator_arg,
+                                                    _default_alloc_t{},
+                                                    std::move(platforms), devt);
+  }
+
+  static auto operator() (cl_device_type devt = CL_DEVICE_TYPE_ALL) ->
+    generator<full_device_id_t>
+  {
+    return self(enum_platforms(), devt);
+  }
+
+  // Allocator-aware overloads: {{{
+  //
+  // Frames of whole chain of nested generators and their buffers are allocated with
+  // the `alloc`, ie. request scoped discovery can keep it off the global heap:
+  //
+  // ``` c++
+  // std::array<std::byte, 16 * 1024> buffer;
+  // std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size()};
+  //
+  // for (auto dev : enum_platform_devices(std::allocator_arg, &arena)) { ... }
+  // ```
+  // }}}
+
+  static auto operator() (std::allocator_arg_t,
+                          _pmr_alloc_t alloc,
+                          ::cl_platform_id pid,
+                          ::cl_device_type device_type = CL_DEVICE_TYPE_ALL) ->
+    pmr_generator<full_device_id_t>
+  {
+    return _devices<pmr_generator<full_device_id_t>>(std::allocator_arg, alloc,
+                                                     pid, device_type);
+  }
+
+  static auto operator() (std::allocator_arg_t,
+                          _pmr_alloc_t alloc,
+                          std::ranges::viewable_range auto platforms,
+                          cl_device_type devt = CL_DEVICE_TYPE_ALL) ->
+    pmr_generator<full_device_id_t>
+  {
+    return _devices_of<pmr_generator<full_device_id_t>>(std::allocator_arg, alloc,
+                                                        std::move(platforms), devt);
+  }
+
+  static auto operator() (std::allocator_arg_t,
+                          _pmr_alloc_t alloc,
+                          cl_device_type devt = CL_DEVICE_TYPE_ALL) ->
+    pmr_generator<full_device_id_t>
+  {
+    return self(std::allocator_arg, alloc,
+                enum_platforms(std::allocator_arg, alloc), devt);
+  }
+
+  // Eager, coroutine-free overloads: {{{
+  //
+  // As the eager `enum_platforms(std::span)`, those fill the caller provided storage
+  // returning filled prefix, truncated to storage size, see `count()`.
+  //
+  // No heap allocation happens, unless single platform has more devices than
+  // `max_stack_platform_devices`.
+  // }}}
+
+  [[nodiscard]]
+  static auto count(::cl_platform_id pid,
+                    ::cl_device_type device_type = CL_DEVICE_TYPE_ALL) -> std::size_t
+  {
+    using clapi::ExpectedFailure;
+
+    static constexpr auto getDeviceIDs = check<::clGetDeviceIDs>;
+
+    cl_uint num_dev;
+
+    if (error_or<> ret = getDeviceIDs(ExpectedFailure,
+                                      pid, device_type, 0, nullptr, &num_dev);
+        not ret)
+    {
+      using namespace clapi::enable_errcode_int_compare;
+
+      if (ret.error() == CL_DEVICE_NOT_FOUND) return 0;
+
+      throw ret.error();
+    }
+
+    return num_dev;
+  }
+
+  [[nodiscard]]
+  static auto count(std::span<const ::cl_platform_id> platforms,
+                    ::cl_device_type device_type = CL_DEVICE_TYPE_ALL) -> std::size_t
+  {
+    std::size_t total = 0;
+    for (auto p : platforms) total += count(p, device_type);
+
+    return total;
+  }
+
+  static auto operator() (::cl_platform_id pid,
+                          std::span<full_device_id_t> storage,
+                          ::cl_device_type device_type = CL_DEVICE_TYPE_ALL) ->
+    std::span<full_device_id_t>
+  {
+    auto num_dev = std::min(count(pid, device_type), storage.size());
+
+    if (num_dev == 0) return storage.first(0);
+
+    std::array<cl_device_id, max_stack_platform_devices> stack_ids;
+    std::vector<cl_device_id> heap_ids;
+
+    std::span<cl_device_id> ids = stack_ids;
+    if (num_dev > stack_ids.size()) [[unlikely]]
+    {
+      heap_ids.resize(num_dev);
+      ids = heap_ids;
+    }
+
+    ids = ids.first(num_dev);
+
+    static constexpr auto getDeviceIDs = check<::clGetDeviceIDs>;
+    static constexpr auto getDeviceInfo = check<::clGetDeviceInfo>;
+
+    if (auto ret = getDeviceIDs(pid, device_type, ids.size(), ids.data(), nullptr); !ret)
+      throw ret.error();
+
+    for (auto &&[out, id] : std::views::zip(storage, ids))
+    {
+      cl_device_type t = device_type;
+
+      // We're asked CL_DEVICE_TYPE_ALL, thus we don't know device type.
+      if (device_type == CL_DEVICE_TYPE_ALL)
+      {
+        if (auto ret = getDeviceInfo(id, CL_DEVICE_TYPE, sizeof(t), &t, nullptr); !ret)
+          throw ret.error();
+      }
+
+      out = full_device_id_t{pid, id, t};
+    }
+
+    return storage.first(num_dev);
+  }
+
+  static auto operator() (std::span<const ::cl_platform_id> platforms,
+                          std::span<full_device_id_t> storage,
+                          ::cl_device_type device_type = CL_DEVICE_TYPE_ALL) ->
+    std::span<full_device_id_t>
+  {
+    std::size_t filled = 0;
+
+    for (auto p : platforms)
+      filled += self(p, storage.subspan(filled), device_type).size();
+
+    return storage.first(filled);
+  }
+
+#if defined(__cpp_lib_inplace_vector)
+  template <std::size_t N_>
+  static auto operator() (std::span<const ::cl_platform_id> platforms,
+                          std::inplace_vector<full_device_id_t, N_> &storage,
+                          ::cl_device_type device_type = CL_DEVICE_TYPE_ALL) -> void
+  {
+    storage.resize(N_);
+    storage.resize(self(platforms, std::span{storage}, device_type).size());
+  }
+#endif
+};
+
+constexpr inline enum_platform_devices_fn enum_platform_devices{};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
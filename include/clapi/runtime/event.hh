@@ -0,0 +1,137 @@
+#pragma once
+
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/query.hh"
+#include "clapi/runtime/worker_pool.hh"
+
+#include <CL/cl.h>
+
+#include <concepts>
+#include <coroutine>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace clapi::runtime
+{
+
+// Runs posted jobs on threads of its own, eg. `worker_pool`
+template <typename Ty_>
+concept executor = requires (Ty_ &e, std::move_only_function<void()> job) {
+  e.post(std::move(job));
+};
+
+static_assert(executor<worker_pool>);
+
+//----------------------------------------------------------------------------------------
+// event_awaiter - suspends the coroutine until the event completes
+//----------------------------------------------------------------------------------------
+//
+// Completion is registered by `clSetEventCallback(CL_COMPLETE)`, callback of the driver
+// just posts resumption to the executor, so no user code runs on the driver's thread.
+// Negative execution status (the command failed) is thrown as `clapi::error_code_t`.
+//
+// ``` c++
+// auto ev = saxpy.enqueue(queue, nd_range{n}, {}, x, y, a, n);
+// co_await on_complete(*ev, pool);
+// ```
+//
+// Note: The queue of the event is flushed before waiting, otherwise {{{
+//       the command might be never submitted and the callback never come.
+//       Event is retained for as long as the coroutine waits.
+// }}}
+
+template <executor Exec_>
+class [[nodiscard]] event_awaiter
+{
+public:
+  event_awaiter(::cl_event ev, Exec_ &exec) noexcept : _event(ev), _exec(&exec) {}
+
+  auto await_ready() noexcept -> bool
+  {
+    ::cl_int status = CL_QUEUED;
+
+    if (not check<::clGetEventInfo>(_event, CL_EVENT_COMMAND_EXECUTION_STATUS,
+                                    sizeof(status), &status, nullptr)) [[unlikely]]
+      return false;
+
+    if (status > CL_COMPLETE) return false;
+
+    _status = status;
+    return true;
+  }
+
+  auto await_suspend(std::coroutine_handle<> h) noexcept -> bool
+  {
+    _waiting = h;
+
+    if (auto retained = event_handle::retain(_event); retained) [[likely]]
+      _retained = *std::move(retained);
+    else
+      return _fail(retained.error());
+
+    _flush();
+
+    // May be called back before even returning, `this` is not to be touched after.
+    auto r = check<::clSetEventCallback>(_event, CL_COMPLETE, _notify, this);
+
+    if (!r) [[unlikely]] return _fail(r.error());
+
+    return true;
+  }
+
+  auto await_resume() -> void
+  {
+    _retained.reset();
+
+    if (_status < CL_COMPLETE) [[unlikely]] throw error_code_t(_status);
+  }
+
+private:
+  static auto CL_CALLBACK _notify(::cl_event, ::cl_int status, void *user_data) noexcept
+    -> void
+  {
+    auto *self = static_cast<event_awaiter *>(user_data);
+
+    self->_status = status;
+    self->_exec->post([h = self->_waiting] { h.resume(); });
+  }
+
+  auto _flush() const noexcept -> void
+  {
+    ::cl_command_queue queue = nullptr;
+
+    // User events have no queue
+    if (check<::clGetEventInfo>(_event, CL_EVENT_COMMAND_QUEUE,
+                                sizeof(queue), &queue, nullptr)
+        and queue)
+      std::ignore = check<::clFlush>(queue);
+  }
+
+  [[clapi_cold_fn]]
+  auto _fail(error_code_t e) noexcept -> bool
+  {
+    _status = ::cl_int(e);
+    return false;
+  }
+
+  ::cl_event _event;
+  Exec_ *_exec;
+
+  event_handle _retained;
+  std::coroutine_handle<> _waiting;
+  ::cl_int _status = CL_QUEUED;
+};
+
+[[nodiscard]]
+auto on_complete(::cl_event ev, executor auto &exec)
+{
+  return event_awaiter<std::remove_cvref_t<decltype(exec)>>{ev, exec};
+}
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "clapi/etc/compiler.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// handle_traits - reference counting functions of OpenCL object type
+//----------------------------------------------------------------------------------------
+
+template <typename Ty_>
+struct handle_traits;
+
+#define _clapi_HANDLE_TRAITS(Type_, Name_)                              \
+  template <>                                                           \
+  struct handle_traits<Type_>                                           \
+  {                                                                     \
+    static constexpr auto retain = check<::clRetain##Name_>;            \
+    static constexpr auto release = check<::clRelease##Name_>;          \
+  }
+
+_clapi_HANDLE_TRAITS(::cl_context, Context);
+_clapi_HANDLE_TRAITS(::cl_command_queue, CommandQueue);
+_clapi_HANDLE_TRAITS(::cl_mem, MemObject);
+_clapi_HANDLE_TRAITS(::cl_program, Program);
+_clapi_HANDLE_TRAITS(::cl_kernel, Kernel);
+_clapi_HANDLE_TRAITS(::cl_event, Event);
+_clapi_HANDLE_TRAITS(::cl_sampler, Sampler);
+// Reference counted are sub-devices only, retaining root device is no-op
+_clapi_HANDLE_TRAITS(::cl_device_id, Device);
+
+#undef _clapi_HANDLE_TRAITS
+
+template <typename Ty_>
+concept reference_counted = requires {
+  handle_traits<Ty_>::retain;
+  handle_traits<Ty_>::release;
+};
+
+//----------------------------------------------------------------------------------------
+// handle - move-only owner of the single reference to OpenCL object
+//----------------------------------------------------------------------------------------
+//
+// Exactly pointer-sized, moves just pass the pointer, never touching the reference
+// count kept by the driver. Only the `retained()` copy and destruction of non-empty
+// handle do call the driver.
+//
+// Note: Destruction of moved-from handles is the common case, {{{
+//       thus the release is kept out of line, behind the `[[unlikely]]` branch.
+//
+//       Failure to release is logged (as any other checked call) and ignored.
+// }}}
+
+template <reference_counted Ty_>
+class handle
+{
+  using _traits = handle_traits<Ty_>;
+
+public:
+  using element_type = Ty_;
+
+  constexpr handle() noexcept = default;
+  constexpr handle(std::nullptr_t) noexcept {}
+
+  // Takes over the reference, eg. of just created object
+  explicit constexpr handle(Ty_ raw) noexcept : _raw(raw) {}
+
+  constexpr handle(handle &&other) noexcept : _raw(std::exchange(other._raw, nullptr)) {}
+
+  constexpr auto operator=(handle &&other) noexcept -> handle &
+  {
+    handle{std::move(other)}.swap(*this);
+    return *this;
+  }
+
+  handle(const handle &) = delete;
+  auto operator=(const handle &) -> handle & = delete;
+
+  ~handle()
+  {
+    if (_raw != nullptr) [[unlikely]] _release(_raw);
+  }
+
+  // Takes the new reference of `raw`
+  [[nodiscard]]
+  static auto retain(Ty_ raw) -> error_or<handle>
+  {
+    if (raw == nullptr) return handle{};
+
+    if (auto r = _traits::retain(raw); !r) [[unlikely]]
+      return std::unexpected(r.error());
+
+    return handle{raw};
+  }
+
+  // Another reference of the same object
+  [[nodiscard]]
+  auto retained() const -> error_or<handle> { return retain(_raw); }
+
+  [[nodiscard]]
+  constexpr auto get() const noexcept -> Ty_ { return _raw; }
+
+  // Hands the reference over to the caller
+  [[nodiscard]]
+  constexpr auto release() noexcept -> Ty_ { return std::exchange(_raw, nullptr); }
+
+  constexpr auto reset(Ty_ raw = nullptr) noexcept -> void { handle{raw}.swap(*this); }
+
+  constexpr auto swap(handle &other) noexcept -> void { std::swap(_raw, other._raw); }
+
+  // Handles pass where raw objects are expected, eg. to `check<>` wrapped calls
+  constexpr operator Ty_() const noexcept { return _raw; }
+
+  explicit constexpr operator bool() const noexcept { return _raw != nullptr; }
+
+  friend constexpr auto operator==(const handle &, const handle &) noexcept
+    -> bool = default;
+
+  friend constexpr auto operator==(const handle &h, std::nullptr_t) noexcept -> bool
+  {
+    return h._raw == nullptr;
+  }
+
+private:
+  [[clapi_cold_fn]]
+  static auto _release(Ty_ raw) noexcept -> void
+  {
+    std::ignore = _traits::release(raw);
+  }
+
+  Ty_ _raw = nullptr;
+};
+
+using context_handle = handle<::cl_context>;
+using queue_handle = handle<::cl_command_queue>;
+using mem_handle = handle<::cl_mem>;
+using program_handle = handle<::cl_program>;
+using kernel_handle = handle<::cl_kernel>;
+using event_handle = handle<::cl_event>;
+using sampler_handle = handle<::cl_sampler>;
+using sub_device_handle = handle<::cl_device_id>;
+
+static_assert(sizeof(context_handle) == sizeof(::cl_context));
+static_assert(std::is_nothrow_move_constructible_v<mem_handle>);
+
+//----------------------------------------------------------------------------------------
+// adopt - owning result of checked call creating OpenCL object
+//----------------------------------------------------------------------------------------
+//
+// ``` c++
+// error_or<context_handle> ctx = adopt(check<::clCreateContext>(...));
+// ```
+
+template <reference_counted Ty_>
+[[nodiscard]]
+auto adopt(error_or<Ty_> created) -> error_or<handle<Ty_>>
+{
+  return std::move(created).transform([] (Ty_ raw) static { return handle<Ty_>{raw}; });
+}
+
+} // namespace clapi::runtime
+
+template <typename Ty_>
+struct std::hash<clapi::runtime::handle<Ty_>>
+{
+  auto operator() (const clapi::runtime::handle<Ty_> &h) const noexcept -> std::size_t
+  {
+    return std::hash<Ty_>{}(h.get());
+  }
+};
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
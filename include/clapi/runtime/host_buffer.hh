@@ -0,0 +1,281 @@
+#pragma once
+
+#include "clapi/etc/basic.hh"
+#include "clapi/runtime/device.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <version>
+
+#if defined(__cpp_lib_mdspan)
+#include <mdspan>
+#endif
+
+namespace clapi::runtime
+{
+
+enum class host_buffer_mode
+{
+  use_host_ptr,     // memory of ours, aligned, used by the device in place
+  alloc_host_ptr,   // pinned memory allocated by the driver
+};
+
+// In-place use for CPU devices and those sharing memory with the host, pinned otherwise
+[[nodiscard]]
+inline auto preferred_host_buffer_mode(::cl_device_id dev) -> host_buffer_mode
+{
+  runtime::device d{dev};
+
+  if ((d.type() & CL_DEVICE_TYPE_CPU) or d.host_unified_memory())
+    return host_buffer_mode::use_host_ptr;
+
+  return host_buffer_mode::alloc_host_ptr;
+}
+
+//----------------------------------------------------------------------------------------
+// mapped_span - host view of the mapped buffer region, unmapped on destruction
+//----------------------------------------------------------------------------------------
+//
+// Unmap is enqueued (not waited for), commands enqueued later to the same in-order
+// queue see the writes.
+
+template <typename Ty_>
+  requires std::is_trivially_copyable_v<Ty_>
+class mapped_span
+{
+public:
+  mapped_span() noexcept = default;
+
+  mapped_span(mapped_span &&other) noexcept :
+    _queue(std::exchange(other._queue, nullptr)),
+    _mem(std::exchange(other._mem, nullptr)),
+    _span(std::exchange(other._span, {}))
+  {}
+
+  auto operator=(mapped_span &&other) noexcept -> mapped_span &
+  {
+    mapped_span{std::move(other)}.swap(*this);
+    return *this;
+  }
+
+  ~mapped_span()
+  {
+    if (_mem)
+      std::ignore = check<::clEnqueueUnmapMemObject>(_queue, _mem, _span.data(),
+                                                     0, nullptr, nullptr);
+  }
+
+  [[nodiscard]]
+  auto span() const noexcept -> std::span<Ty_> { return _span; }
+
+  operator std::span<Ty_>() const noexcept { return _span; }
+
+  [[nodiscard]]
+  auto data() const noexcept -> Ty_ * { return _span.data(); }
+
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t { return _span.size(); }
+
+  [[nodiscard]]
+  auto begin() const noexcept { return _span.begin(); }
+
+  [[nodiscard]]
+  auto end() const noexcept { return _span.end(); }
+
+  auto operator[](std::size_t i) const noexcept -> Ty_ & { return _span[i]; }
+
+#if defined(__cpp_lib_mdspan)
+  // Multi-dimensional view of the same memory (row-major), extents must fit the span
+  template <typename Extents_>
+  [[nodiscard]]
+  auto mdspan(const Extents_ &extents) const noexcept -> std::mdspan<Ty_, Extents_>
+  {
+    return std::mdspan<Ty_, Extents_>{_span.data(), extents};
+  }
+#endif
+
+  auto swap(mapped_span &other) noexcept -> void
+  {
+    std::swap(_queue, other._queue);
+    std::swap(_mem, other._mem);
+    std::swap(_span, other._span);
+  }
+
+private:
+  friend class host_buffer;
+
+  mapped_span(::cl_command_queue queue, ::cl_mem mem, std::span<Ty_> span) noexcept :
+    _queue(queue), _mem(mem), _span(span)
+  {}
+
+  ::cl_command_queue _queue = nullptr;
+  ::cl_mem _mem = nullptr;
+  std::span<Ty_> _span;
+};
+
+//----------------------------------------------------------------------------------------
+// host_buffer - zero-copy buffer in host memory
+//----------------------------------------------------------------------------------------
+//
+// On CPU devices and integrated GPUs (`CL_DEVICE_HOST_UNIFIED_MEMORY`) data is shared
+// in place rather than copied by `clEnqueueWriteBuffer`. Host memory is allocated
+// aligned to both `CL_DEVICE_MEM_BASE_ADDR_ALIGN` and the page, size rounded up to it,
+// so the driver can use it with no shadow copy (`CL_MEM_USE_HOST_PTR`). Other devices
+// get driver allocated pinned memory (`CL_MEM_ALLOC_HOST_PTR`).
+//
+// Host access is by `map()`, which is just a synchronization of pointer already known
+// for zero-copy buffers:
+//
+// ``` c++
+// host_buffer buf{ctx, dev, n * sizeof(float)};
+// {
+//   auto in = buf.map<float>(queue, CL_MAP_WRITE_INVALIDATE_REGION);
+//   std::ranges::fill(in, 1.0f);
+// }
+// // enqueue kernels on buf.get()
+// ```
+//
+// Note: The buffer must not be used by devices while it is mapped. {{{
+//       The mapped span must not outlive the buffer.
+// }}}
+
+class host_buffer
+{
+public:
+  host_buffer(::cl_context ctx,
+              ::cl_device_id dev,
+              std::size_t bytes,
+              ::cl_mem_flags access = CL_MEM_READ_WRITE) :
+    host_buffer(ctx, dev, bytes, access, preferred_host_buffer_mode(dev))
+  {}
+
+  host_buffer(::cl_context ctx,
+              ::cl_device_id dev,
+              std::size_t bytes,
+              ::cl_mem_flags access,
+              host_buffer_mode mode) :
+    _bytes(bytes), _mode(mode)
+  {
+    ::cl_mem_flags flags = access;
+
+    if (mode == host_buffer_mode::use_host_ptr)
+    {
+      const std::size_t align = alignment_for(dev);
+      const std::size_t size = (std::max<std::size_t>(bytes, 1) + align - 1) & ~(align - 1);
+
+      _host.reset(static_cast<std::byte *>(::operator new(size, std::align_val_t{align})));
+      _host.get_deleter().align = align;
+
+      flags |= CL_MEM_USE_HOST_PTR;
+    }
+    else
+      flags |= CL_MEM_ALLOC_HOST_PTR;
+
+    auto mem = adopt(check<::clCreateBuffer>(ctx, flags, std::max<std::size_t>(bytes, 1),
+                                             _host.get()));
+    if (!mem) [[unlikely]] throw mem.error();
+
+    _mem = *std::move(mem);
+
+    // The driver may use host memory till its last command is done, even after release
+    if (_host)
+    {
+      auto *block = new _host_block{_host.get(), _host.get_deleter().align};
+
+      auto r = check<::clSetMemObjectDestructorCallback>(_mem.get(), _free_host, block);
+
+      if (r) [[likely]] std::ignore = _host.release();
+      else delete block;
+    }
+  }
+
+  // Both of the page and the base address alignment of the device
+  [[nodiscard]]
+  static auto alignment_for(::cl_device_id dev) -> std::size_t
+  {
+    const std::size_t page = std::size_t(::sysconf(_SC_PAGESIZE));
+    const std::size_t base = runtime::device{dev}.mem_base_addr_align();
+
+    return std::bit_ceil(std::max({page, base, alignof(std::max_align_t)}));
+  }
+
+  // Blocking map of the whole buffer (or its typed part)
+  template <typename Ty_>
+  [[nodiscard]]
+  auto map(::cl_command_queue queue,
+           ::cl_map_flags flags = CL_MAP_READ | CL_MAP_WRITE,
+           std::size_t offset = 0,
+           std::size_t count = std::size_t(-1)) -> mapped_span<Ty_>
+  {
+    count = std::min(count, (_bytes - std::min(_bytes, offset)) / sizeof(Ty_));
+
+    auto p = check<::clEnqueueMapBuffer>(queue, _mem.get(), CL_TRUE, flags,
+                                         offset, count * sizeof(Ty_),
+                                         0, nullptr, nullptr);
+    if (!p) [[unlikely]] throw p.error();
+
+    return {queue, _mem.get(), {static_cast<Ty_ *>(*p), count}};
+  }
+
+  [[nodiscard]]
+  auto get() const noexcept -> ::cl_mem { return _mem.get(); }
+
+  operator ::cl_mem() const noexcept { return _mem.get(); }
+
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t { return _bytes; }
+
+  [[nodiscard]]
+  auto mode() const noexcept -> host_buffer_mode { return _mode; }
+
+private:
+  struct _aligned_delete
+  {
+    std::size_t align = alignof(std::max_align_t);
+
+    auto operator()(std::byte *p) const noexcept -> void
+    {
+      ::operator delete(p, std::align_val_t{align});
+    }
+  };
+
+  struct _host_block
+  {
+    std::byte *p;
+    std::size_t align;
+  };
+
+  static auto CL_CALLBACK _free_host(::cl_mem, void *user_data) noexcept -> void
+  {
+    std::unique_ptr<_host_block> block{static_cast<_host_block *>(user_data)};
+
+    _aligned_delete{block->align}(block->p);
+  }
+
+  std::size_t _bytes;
+  host_buffer_mode _mode;
+
+  // Owned by the destructor callback of the buffer, unless that failed to register.
+  // Released after the buffer then, members are destroyed in reverse.
+  std::unique_ptr<std::byte, _aligned_delete> _host;
+  mem_handle _mem;
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,254 @@
+#pragma once
+
+#include "clapi/etc/basic.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+class intern_table;
+
+//----------------------------------------------------------------------------------------
+// interned - 32-bit handle of the string stored in the process-wide `intern_table`
+//----------------------------------------------------------------------------------------
+//
+// Equal strings are always given the same handle, thus equality is the single integer
+// compare. The default constructed handle refers to an empty string.
+//
+// Note: Ordering is the order of interning, not the lexicographical one. {{{
+//       It's only meant for keying ordered containers.
+// }}}
+
+class interned
+{
+public:
+  using id_t = std::uint32_t;
+
+  constexpr interned() noexcept = default;
+
+  // Rebuilds handle from its `id()`, as carried by log and trace records.
+  [[nodiscard]]
+  static constexpr auto from_id(id_t id) noexcept -> interned { return interned{id}; }
+
+  [[nodiscard]]
+  constexpr auto id() const noexcept -> id_t { return _id; }
+
+  [[nodiscard]]
+  auto view() const noexcept -> std::string_view;
+
+  [[nodiscard]]
+  auto empty() const noexcept -> bool { return view().empty(); }
+
+  operator std::string_view() const noexcept { return view(); }
+
+  friend constexpr auto operator==(interned, interned) noexcept -> bool = default;
+  friend constexpr auto operator<=>(interned, interned) noexcept = default;
+
+private:
+  friend intern_table;
+
+  explicit constexpr interned(id_t id) noexcept : _id(id) {}
+
+  id_t _id = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// intern_table - thread-safe, append-only storage of unique strings
+//----------------------------------------------------------------------------------------
+//
+// Interned characters are never moved nor freed for a lifetime of the table,
+// thus `std::string_view` of interned string stays valid as long as the table does.
+//
+// Note: Resolving handle to `std::string_view` takes no locks, {{{
+//       interning takes shared lock when string is already known and exclusive lock
+//       the first time it is seen.
+// }}}
+
+class intern_table : immovable<intern_table>
+{
+  static constexpr std::size_t _chunk_bits = 10;
+  static constexpr std::size_t _chunk_size = std::size_t(1) << _chunk_bits;
+  static constexpr std::size_t _max_chunks = std::size_t(1) << 12;
+  static constexpr std::size_t _block_size = 16 * 1024;
+
+  using chunk_t = std::array<std::string_view, _chunk_size>;
+
+  struct _hash
+  {
+    using is_transparent = void;
+
+    auto operator() (std::string_view s) const noexcept -> std::size_t
+    {
+      return std::hash<std::string_view>{}(s);
+    }
+  };
+
+public:
+  intern_table()
+  {
+    // Handle of id 0 is an empty string
+    _append({});
+  }
+
+  ~intern_table()
+  {
+    for (auto &c : _chunks) delete c.load(std::memory_order_relaxed);
+  }
+
+  // The process-wide table
+  [[nodiscard]]
+  static auto instance() -> intern_table &
+  {
+    static intern_table table;
+    return table;
+  }
+
+  [[nodiscard]]
+  auto intern(std::string_view s) -> interned
+  {
+    if (s.empty()) return {};
+
+    {
+      std::shared_lock lock{_mutex};
+
+      if (auto it = _index.find(s); it != _index.end()) [[likely]]
+        return interned{it->second};
+    }
+
+    std::scoped_lock lock{_mutex};
+
+    // Someone might have been faster
+    if (auto it = _index.find(s); it != _index.end())
+      return interned{it->second};
+
+    auto stored = _store(s);
+    auto id = _append(stored);
+
+    _index.emplace(stored, id);
+
+    return interned{id};
+  }
+
+  [[nodiscard]]
+  auto view(interned h) const noexcept -> std::string_view
+  {
+    auto id = h.id();
+
+    assert(id < _size.load(std::memory_order_acquire));
+
+    const chunk_t *chunk = _chunks[id >> _chunk_bits].load(std::memory_order_acquire);
+    return (*chunk)[id & (_chunk_size - 1)];
+  }
+
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t
+  {
+    return _size.load(std::memory_order_acquire);
+  }
+
+private:
+  // Copies characters into never moving storage.
+  auto _store(std::string_view s) -> std::string_view
+  {
+    if (s.size() > _block_left)
+    {
+      auto capacity = std::max(_block_size, s.size());
+
+      _blocks.push_back(std::make_unique_for_overwrite<char[]>(capacity));
+      _block_cursor = _blocks.back().get();
+      _block_left = capacity;
+    }
+
+    auto stored = std::string_view{_block_cursor, s.size()};
+
+    std::ranges::copy(s, _block_cursor);
+    _block_cursor += s.size();
+    _block_left -= s.size();
+
+    return stored;
+  }
+
+  auto _append(std::string_view stored) -> interned::id_t
+  {
+    auto id = _size.load(std::memory_order_relaxed);
+
+    if (id == _chunk_size * _max_chunks) [[unlikely]]
+      throw std::length_error("clapi::runtime::intern_table is full");
+
+    auto &slot = _chunks[id >> _chunk_bits];
+    auto *chunk = slot.load(std::memory_order_relaxed);
+
+    if (chunk == nullptr)
+    {
+      chunk = new chunk_t{};
+      slot.store(chunk, std::memory_order_release);
+    }
+
+    (*chunk)[id & (_chunk_size - 1)] = stored;
+
+    // Publishes the entry for lock-free `view()`
+    _size.store(id + 1, std::memory_order_release);
+
+    return interned::id_t(id);
+  }
+
+  std::shared_mutex _mutex;
+  std::unordered_map<std::string_view, interned::id_t, _hash, std::equal_to<>> _index;
+
+  std::vector<std::unique_ptr<char[]>> _blocks;
+  char *_block_cursor = nullptr;
+  std::size_t _block_left = 0;
+
+  std::array<std::atomic<chunk_t *>, _max_chunks> _chunks{};
+  std::atomic<std::size_t> _size{0};
+};
+
+inline auto interned::view() const noexcept -> std::string_view
+{
+  return intern_table::instance().view(*this);
+}
+
+[[nodiscard]]
+inline auto intern(std::string_view s) -> interned
+{
+  return intern_table::instance().intern(s);
+}
+
+} // namespace clapi::runtime
+
+template <>
+struct std::hash<clapi::runtime::interned>
+{
+  auto operator() (clapi::runtime::interned h) const noexcept -> std::size_t
+  {
+    return std::hash<clapi::runtime::interned::id_t>{}(h.id());
+  }
+};
+
+template <>
+struct std::formatter<clapi::runtime::interned> : std::formatter<std::string_view>
+{
+  auto format(clapi::runtime::interned h, auto &ctx) const
+  {
+    return std::formatter<std::string_view>::format(h.view(), ctx);
+  }
+};
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
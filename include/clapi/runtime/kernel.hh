@@ -0,0 +1,317 @@
+#pragma once
+
+#include "clapi/etc/param_optimization.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace clapi::runtime
+{
+
+// Argument in `__local` address space, just its size is set
+struct local_memory
+{
+  std::size_t bytes;
+};
+
+// OpenCL objects passed as kernel arguments by the handle
+template <typename Ty_>
+concept kernel_object_argument = std::same_as<Ty_, ::cl_mem>
+                                 or std::same_as<Ty_, ::cl_sampler>
+                                 or std::same_as<Ty_, ::cl_command_queue>;
+
+template <typename Ty_>
+concept kernel_argument = std::same_as<Ty_, local_memory>
+                          or kernel_object_argument<Ty_>
+                          or (std::is_trivially_copyable_v<Ty_>
+                              and std::is_standard_layout_v<Ty_>
+                              and not std::is_pointer_v<Ty_>
+                              and not std::is_reference_v<Ty_>);
+
+//----------------------------------------------------------------------------------------
+// nd_range - global and local work size of the launch (1 to 3 dimensions)
+//----------------------------------------------------------------------------------------
+//
+// Local size of zeros is left for the driver to choose. Only 1-D global size converts
+// implicitly, ranges with the local size or more dimensions are spelled by `d1()`,
+// `d2()` and `d3()`, so 2-D range can't be mistaken for 1-D global and local one.
+//
+// ``` c++
+// nd_range{n};                            // 1-D, n work-items
+// nd_range::d1(n, 64);                    // 1-D, work-groups of 64
+// nd_range::d2({w, h}, {16, 16});         // 2-D
+// ```
+
+struct nd_range
+{
+  ::cl_uint dims;
+  std::array<std::size_t, 3> global;
+  std::array<std::size_t, 3> local{};
+  std::array<std::size_t, 3> offset{};
+
+  constexpr nd_range(std::size_t global0) noexcept : dims(1), global{global0, 1, 1} {}
+
+  [[nodiscard]]
+  static constexpr auto d1(std::size_t global0, std::size_t local0 = 0) noexcept -> nd_range
+  {
+    return {1, {global0, 1, 1}, {local0, 0, 0}};
+  }
+
+  [[nodiscard]]
+  static constexpr auto d2(std::array<std::size_t, 2> g,
+                           std::array<std::size_t, 2> l = {}) noexcept -> nd_range
+  {
+    return {2, {g[0], g[1], 1}, {l[0], l[1], 0}};
+  }
+
+  [[nodiscard]]
+  static constexpr auto d3(std::array<std::size_t, 3> g,
+                           std::array<std::size_t, 3> l = {}) noexcept -> nd_range
+  {
+    return {3, g, l};
+  }
+
+  [[nodiscard]]
+  constexpr auto local_size() const noexcept -> const std::size_t *
+  {
+    return local[0] ? local.data() : nullptr;
+  }
+
+private:
+  constexpr nd_range(::cl_uint d,
+                     std::array<std::size_t, 3> g,
+                     std::array<std::size_t, 3> l) noexcept :
+    dims(d), global(g), local(l)
+  {}
+};
+
+} // namespace clapi::runtime
+
+namespace clapi::_detail::runtime
+{
+
+using namespace clapi::runtime;
+
+// Passed by value when it fits two words (`param_opt_t`), by const reference otherwise,
+// kernel arguments are only read.
+template <typename Ty_>
+using _kernel_param_t = std::conditional_t<std::is_reference_v<param_opt_t<Ty_, 2>>,
+                                           const Ty_ &,
+                                           param_opt_t<Ty_, 2>>;
+
+template <typename Given_, typename Arg_>
+concept _exact_argument =
+  std::same_as<std::remove_cvref_t<Given_>, Arg_>
+  or (std::same_as<Arg_, ::cl_mem> and std::same_as<std::remove_cvref_t<Given_>, mem_handle>)
+  or (std::same_as<Arg_, ::cl_sampler>
+      and std::same_as<std::remove_cvref_t<Given_>, sampler_handle>);
+
+// Object representation of the value last set, for the argument slot
+template <typename Ty_>
+struct _arg_slot
+{
+  std::array<std::byte, sizeof(Ty_)> last;
+  bool bound = false;
+};
+
+template <typename Ty_>
+[[nodiscard]]
+inline auto _representation(const Ty_ &v) noexcept -> std::array<std::byte, sizeof(Ty_)>
+{
+  std::array<std::byte, sizeof(Ty_)> bytes;
+  std::memcpy(bytes.data(), &v, sizeof(Ty_));
+  return bytes;
+}
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// kernel - typed launcher, sets all of the arguments and enqueues at once
+//----------------------------------------------------------------------------------------
+//
+// Arguments are checked at compile time against the declared signature, exactly:
+// implicit conversions (eg. `int` to `cl_uint`, `double` to `cl_float`) do not compile.
+// `mem_handle` and `sampler_handle` pass for `cl_mem` and `cl_sampler`.
+//
+// ``` c++
+// kernel<::cl_mem, ::cl_mem, ::cl_float, ::cl_uint> saxpy{program, "saxpy"};
+//
+// saxpy(queue, nd_range{n}, x, y, 2.0f, ::cl_uint(n));
+// ```
+//
+// Note: The launcher remembers last value set to each argument and skips {{{
+//       `clSetKernelArg` when it is unchanged, as buffers and sizes of steady-state
+//       loops mostly are. Values are compared by the object representation, thus
+//       padding bytes may only cost redundant set, never a missed one.
+//
+//       Arguments set on the kernel behind the launcher's back require `forget()`.
+//       Like `cl_kernel` itself, the launcher is not to be used by many threads at once,
+//       see `kernel_pool`.
+// }}}
+
+template <kernel_argument... Args_>
+class kernel
+{
+public:
+  static constexpr std::size_t arity = sizeof...(Args_);
+
+  // Number of arguments of the kernel is checked against the declared signature
+  explicit kernel(kernel_handle k) : _kernel(std::move(k))
+  {
+    ::cl_uint nargs = 0;
+
+    if (auto r = check<::clGetKernelInfo>(_kernel.get(), CL_KERNEL_NUM_ARGS,
+                                          sizeof(nargs), &nargs, nullptr);
+        !r) [[unlikely]]
+      throw r.error();
+
+    if (nargs != arity) [[unlikely]] throw error_code_t(CL_INVALID_KERNEL_ARGS);
+  }
+
+  kernel(::cl_program program, std::string_view name) :
+    kernel(_create(program, name))
+  {}
+
+  kernel(kernel &&) noexcept = default;
+  auto operator=(kernel &&) noexcept -> kernel & = default;
+
+  auto operator()(::cl_command_queue queue,
+                  const nd_range &range,
+                  _detail::runtime::_kernel_param_t<Args_>... args) -> error_or<>
+  {
+    return _launch(queue, range, {}, nullptr, args...);
+  }
+
+  template <typename... Given_>
+    requires (sizeof...(Given_) == arity)
+             and (not (_detail::runtime::_exact_argument<Given_, Args_> and ...))
+  auto operator()(::cl_command_queue, const nd_range &, Given_ &&...)
+    -> error_or<> = delete;
+
+  // Launch waiting for the events, with event of its completion
+  [[nodiscard]]
+  auto enqueue(::cl_command_queue queue,
+               const nd_range &range,
+               std::span<const ::cl_event> wait,
+               _detail::runtime::_kernel_param_t<Args_>... args) -> error_or<event_handle>
+  {
+    ::cl_event done = nullptr;
+
+    if (auto r = _launch(queue, range, wait, &done, args...); !r) [[unlikely]]
+      return std::unexpected(r.error());
+
+    return event_handle{done};
+  }
+
+  template <typename... Given_>
+    requires (sizeof...(Given_) == arity)
+             and (not (_detail::runtime::_exact_argument<Given_, Args_> and ...))
+  auto enqueue(::cl_command_queue, const nd_range &, std::span<const ::cl_event>,
+               Given_ &&...)
+    -> error_or<event_handle> = delete;
+
+  // Arguments were set on `get()` directly, none of remembered values holds
+  auto forget() noexcept -> void
+  {
+    std::apply([] (auto &...slot) { ((slot.bound = false), ...); }, _slots);
+  }
+
+  [[nodiscard]]
+  auto get() const noexcept -> ::cl_kernel { return _kernel.get(); }
+
+  // Number of `clSetKernelArg` calls made, and skipped as redundant
+  [[nodiscard]]
+  auto set_calls() const noexcept -> std::uint64_t { return _set_calls; }
+
+  [[nodiscard]]
+  auto elided() const noexcept -> std::uint64_t { return _elided; }
+
+private:
+  static auto _create(::cl_program program, std::string_view name) -> kernel_handle
+  {
+    std::string n{name};
+
+    auto k = adopt(check<::clCreateKernel>(program, n.c_str()));
+    if (!k) [[unlikely]] throw k.error();
+
+    return *std::move(k);
+  }
+
+  auto _launch(::cl_command_queue queue,
+               const nd_range &range,
+               std::span<const ::cl_event> wait,
+               ::cl_event *done,
+               _detail::runtime::_kernel_param_t<Args_>... args) -> error_or<>
+  {
+    error_or<> bound;
+
+    [&]<std::size_t... I_>(std::index_sequence<I_...>) {
+      (bool(bound = _bind<I_>(args)) and ...);
+    }(std::index_sequence_for<Args_...>{});
+
+    if (!bound) [[unlikely]] return bound;
+
+    return check<::clEnqueueNDRangeKernel>(queue, _kernel.get(), range.dims,
+                                           range.offset.data(), range.global.data(),
+                                           range.local_size(),
+                                           ::cl_uint(wait.size()),
+                                           wait.empty() ? nullptr : wait.data(),
+                                           done);
+  }
+
+  template <std::size_t I_, typename Ty_>
+  auto _bind(const Ty_ &value) -> error_or<>
+  {
+    auto &slot = std::get<I_>(_slots);
+    auto bytes = _detail::runtime::_representation(value);
+
+    if (slot.bound and slot.last == bytes) [[likely]]
+    {
+      ++_elided;
+      return {};
+    }
+
+    ++_set_calls;
+
+    error_or<> r;
+
+    if constexpr (std::same_as<Ty_, local_memory>)
+      r = check<::clSetKernelArg>(_kernel.get(), ::cl_uint(I_), value.bytes, nullptr);
+    else
+      r = check<::clSetKernelArg>(_kernel.get(), ::cl_uint(I_), sizeof(Ty_), &value);
+
+    // Failed set leaves the argument in unknown state
+    slot.bound = bool(r);
+    slot.last = bytes;
+
+    return r;
+  }
+
+  kernel_handle _kernel;
+  std::tuple<_detail::runtime::_arg_slot<Args_>...> _slots;
+
+  std::uint64_t _set_calls = 0;
+  std::uint64_t _elided = 0;
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
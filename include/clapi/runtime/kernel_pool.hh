@@ -0,0 +1,253 @@
+#pragma once
+
+#include "clapi/etc/basic.hh"
+#include "clapi/runtime/device.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace clapi::_detail::runtime
+{
+
+using namespace clapi::runtime;
+
+struct _kernel_pool_state
+{
+  std::uint64_t id;
+  program_handle program;
+  kernel_handle prototype;
+  std::string name;
+
+  // Platform and all devices of the program are OpenCL 2.1+, set on construction
+  bool clone = false;
+  std::atomic<std::size_t> instances{0};
+
+  static inline std::atomic<std::uint64_t> _next_id{1};
+};
+
+struct _kernel_instance
+{
+  std::uint64_t pool;
+  std::weak_ptr<_kernel_pool_state> alive;
+  kernel_handle kernel;
+};
+
+// Kernels of the calling thread, of all the pools it used
+inline thread_local std::vector<_kernel_instance> _thread_kernels;
+
+// Parses "OpenCL <major>.<minor> <vendor-specific>" of pre 3.0 version strings
+inline auto _parse_opencl_version(std::string_view version) noexcept -> ::cl_version
+{
+  constexpr std::string_view prefix = "OpenCL ";
+
+  if (not version.starts_with(prefix)) return 0;
+  version.remove_prefix(prefix.size());
+
+  const char *end = version.data() + version.size();
+  unsigned major = 0, minor = 0;
+
+  auto [dot, e1] = std::from_chars(version.data(), end, major);
+  if (e1 != std::errc{} or dot == end or *dot != '.') return 0;
+
+  if (auto [_, e2] = std::from_chars(dot + 1, end, minor); e2 != std::errc{}) return 0;
+
+  return CL_MAKE_VERSION(major, minor, 0);
+}
+
+// Of device or platform proxy, `CL_*_NUMERIC_VERSION` is OpenCL 3.0+ only
+template <typename Proxy_>
+auto _opencl_version_of(const Proxy_ &proxy) -> ::cl_version
+{
+  if (auto v = proxy.numeric_version()) return *v;
+
+  return _parse_opencl_version(proxy.version());
+}
+
+// Whether `clCloneKernel` may be called at all: dispatched through the ICD loader,
+// it's not to be called for platforms predating OpenCL 2.1, not even to fail.
+inline auto _supports_clone(::cl_program program) -> bool
+{
+#if defined(CL_VERSION_2_1)
+  ::cl_uint count = 0;
+
+  if (not check<::clGetProgramInfo>(program, CL_PROGRAM_NUM_DEVICES,
+                                    sizeof(count), &count, nullptr)
+      or count == 0)
+    return false;
+
+  std::vector<::cl_device_id> devices(count);
+
+  if (not check<::clGetProgramInfo>(program, CL_PROGRAM_DEVICES,
+                                    count * sizeof(::cl_device_id), devices.data(),
+                                    nullptr))
+    return false;
+
+  constexpr ::cl_version required = CL_MAKE_VERSION(2, 1, 0);
+
+  return std::ranges::all_of(devices, [] (::cl_device_id dev) {
+    runtime::device d{dev};
+
+    return _opencl_version_of(d) >= required
+           and _opencl_version_of(d.platform()) >= required;
+  });
+#else
+  return false;
+#endif
+}
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// kernel_pool - kernel instance per thread, for lock-free `clSetKernelArg`
+//----------------------------------------------------------------------------------------
+//
+// `cl_kernel` is not safe for concurrent `clSetKernelArg`, the pool hands each thread
+// its own instance of the kernel. The instance is created on first `local()` call
+// of the thread, by `clCloneKernel` (OpenCL 2.1+), `clCreateKernel` otherwise, then
+// kept thread-local, thus later calls take no locks.
+//
+// ``` c++
+// kernel_pool saxpy{program, "saxpy"};
+//
+// // any thread
+// ::cl_kernel k = saxpy.local();
+// check<::clSetKernelArg>(k, 0, sizeof(a), &a);
+// ```
+//
+// Note: Clones copy arguments set on the `prototype()` until then, {{{
+//       kernels created by `clCreateKernel` start with no arguments set. Arguments
+//       should be set before every launch unless the cloning is known to be used.
+//
+//       Instances are owned by threads, they outlive the pool until the thread
+//       exits or misses its kernel of another pool. The program stays alive as long
+//       as any of its kernels do. Creation failure throws `clapi::error_code_t`.
+// }}}
+
+class kernel_pool : immovable<kernel_pool>
+{
+  using _state_t = _detail::runtime::_kernel_pool_state;
+
+public:
+  kernel_pool(::cl_program program, std::string_view name) :
+    _state(std::make_shared<_state_t>())
+  {
+    _state->id = _state_t::_next_id.fetch_add(1, std::memory_order_relaxed);
+    _state->name = name;
+
+    auto retained = program_handle::retain(program);
+    if (!retained) [[unlikely]] throw retained.error();
+
+    _state->program = *std::move(retained);
+
+    auto prototype = adopt(check<::clCreateKernel>(program, _state->name.c_str()));
+    if (!prototype) [[unlikely]] throw prototype.error();
+
+    _state->prototype = *std::move(prototype);
+    _state->clone = _detail::runtime::_supports_clone(program);
+  }
+
+  // Pools the existing kernel, with arguments set on it (as far as cloning goes)
+  explicit kernel_pool(kernel_handle prototype) :
+    _state(std::make_shared<_state_t>())
+  {
+    _state->id = _state_t::_next_id.fetch_add(1, std::memory_order_relaxed);
+    _state->name = query_string_property_<::clGetKernelInfo>(prototype.get(),
+                                                             CL_KERNEL_FUNCTION_NAME);
+    ::cl_program program = nullptr;
+
+    if (auto r = check<::clGetKernelInfo>(prototype.get(), CL_KERNEL_PROGRAM,
+                                          sizeof(program), &program, nullptr);
+        !r) [[unlikely]]
+      throw r.error();
+
+    auto retained = program_handle::retain(program);
+    if (!retained) [[unlikely]] throw retained.error();
+
+    _state->program = *std::move(retained);
+    _state->prototype = std::move(prototype);
+    _state->clone = _detail::runtime::_supports_clone(program);
+  }
+
+  // Kernel of the calling thread, not to be shared with other threads
+  [[nodiscard]]
+  auto local() const -> ::cl_kernel
+  {
+    for (const auto &k : _detail::runtime::_thread_kernels)
+      if (k.pool == _state->id) [[likely]] return k.kernel.get();
+
+    return _add_local();
+  }
+
+  [[nodiscard]]
+  auto prototype() const noexcept -> ::cl_kernel { return _state->prototype.get(); }
+
+  [[nodiscard]]
+  auto name() const noexcept -> std::string_view { return _state->name; }
+
+  // Number of per-thread instances created so far
+  [[nodiscard]]
+  auto instances() const noexcept -> std::size_t
+  {
+    return _state->instances.load(std::memory_order_relaxed);
+  }
+
+  // Whether instances are cloned, ie. the platform and devices are OpenCL 2.1+
+  [[nodiscard]]
+  auto cloning() const noexcept -> bool { return _state->clone; }
+
+private:
+  [[clapi_cold_fn]]
+  auto _add_local() const -> ::cl_kernel
+  {
+    auto &kernels = _detail::runtime::_thread_kernels;
+
+    // Instances of destroyed pools
+    std::erase_if(kernels, [] (const auto &k) { return k.alive.expired(); });
+
+    auto kernel = _create();
+    auto raw = kernel.get();
+
+    kernels.push_back({_state->id, _state, std::move(kernel)});
+    _state->instances.fetch_add(1, std::memory_order_relaxed);
+
+    return raw;
+  }
+
+  auto _create() const -> kernel_handle
+  {
+#if defined(CL_VERSION_2_1)
+    // Failed clone is created anew, the next instance is cloned again
+    if (_state->clone) [[likely]]
+      if (auto k = adopt(check<::clCloneKernel>(_state->prototype.get())); k) [[likely]]
+        return *std::move(k);
+#endif
+
+    auto k = adopt(check<::clCreateKernel>(_state->program.get(), _state->name.c_str()));
+    if (!k) [[unlikely]] throw k.error();
+
+    return *std::move(k);
+  }
+
+  std::shared_ptr<_state_t> _state;
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <expected>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// median_time - median wall time of `reps` runs of `fn` (after single warm-up run)
+//----------------------------------------------------------------------------------------
+
+template <typename Duration_ = std::chrono::duration<double>, std::invocable Fn_>
+[[nodiscard]]
+auto median_time(unsigned reps, Fn_ &&fn) -> Duration_
+{
+  using clock_t = std::chrono::steady_clock;
+
+  std::invoke(fn);
+
+  std::vector<Duration_> samples;
+  samples.reserve(std::max(1u, reps));
+
+  for (unsigned i = 0; i < std::max(1u, reps); ++i)
+  {
+    auto start = clock_t::now();
+    std::invoke(fn);
+    samples.push_back(std::chrono::duration_cast<Duration_>(clock_t::now() - start));
+  }
+
+  auto mid = samples.begin() + samples.size() / 2;
+  std::ranges::nth_element(samples, mid);
+
+  return *mid;
+}
+
+//----------------------------------------------------------------------------------------
+// ok - value of the checked API call, throws its error otherwise
+//----------------------------------------------------------------------------------------
+
+template <typename Ty_, typename Err_>
+auto ok(std::expected<Ty_, Err_> r) -> Ty_
+{
+  if (!r) [[unlikely]] throw r.error();
+
+  if constexpr (not std::is_void_v<Ty_>) return *std::move(r);
+}
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
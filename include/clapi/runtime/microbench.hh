@@ -0,0 +1,286 @@
+#pragma once
+
+#include "clapi/runtime/device.hh"
+#include "clapi/runtime/disk_cache.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/measure.hh"
+#include "clapi/runtime/query.hh"
+#include "clapi/runtime/registry.hh"
+#include "clapi/runtime/scoring.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// microbench_results - measured performance of single device
+//----------------------------------------------------------------------------------------
+
+struct microbench_results
+{
+  double h2d_gbps;           // host to device transfer
+  double d2h_gbps;           // device to host transfer
+  double d2d_gbps;           // on-device copy, counting both read and write
+  double launch_latency_us;  // enqueue + finish of an empty kernel
+  double fp32_gflops;        // peak of fused multiply-add
+
+  [[nodiscard]]
+  auto measurements() const noexcept -> device_measurements
+  {
+    return {.bandwidth_gbps = d2d_gbps};
+  }
+};
+
+} // namespace clapi::runtime
+
+namespace clapi::_detail::runtime
+{
+
+using namespace clapi::runtime;
+
+constexpr inline const char *_microbench_src = R"CL(
+kernel void empty() {}
+
+kernel void fma_peak(global float *out, float a, float b)
+{
+  float x0 = get_global_id(0), x1 = x0 + 1, x2 = x0 + 2, x3 = x0 + 3;
+
+  for (int i = 0; i < 256; ++i)
+  {
+    x0 = mad(x0, a, b); x1 = mad(x1, a, b);
+    x2 = mad(x2, a, b); x3 = mad(x3, a, b);
+  }
+
+  out[get_global_id(0)] = x0 + x1 + x2 + x3;
+}
+)CL";
+
+// FMA counts as two operations, four chains of 256 each per work-item
+constexpr inline double _microbench_flops_per_item = 2.0 * 4 * 256;
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// run_microbenchmarks - measures the device, takes about a second
+//----------------------------------------------------------------------------------------
+//
+// Throws `clapi::error_code_t` on any failure of the API.
+
+[[nodiscard]]
+inline auto run_microbenchmarks(::cl_device_id dev) -> microbench_results
+{
+  using namespace _detail::runtime;
+
+  constexpr unsigned reps = 9;
+  constexpr unsigned latency_reps = 101;
+
+  const std::size_t max_alloc = query_integral_property_<::clGetDeviceInfo, ::cl_ulong>(
+    dev, CL_DEVICE_MAX_MEM_ALLOC_SIZE);
+
+  const std::size_t bytes = std::min<std::size_t>(std::size_t(64) << 20, max_alloc / 4);
+
+  auto context = ok(adopt(check<::clCreateContext>(nullptr, 1, &dev, nullptr, nullptr)));
+  auto queue = ok(adopt(check<::clCreateCommandQueueWithProperties>(context, dev,
+                                                                    nullptr)));
+
+  const char *src = _microbench_src;
+  auto program = ok(adopt(check<::clCreateProgramWithSource>(context, 1, &src, nullptr)));
+  ok(check<::clBuildProgram>(program, 1, &dev, nullptr, nullptr, nullptr));
+
+  auto src_buf = ok(adopt(check<::clCreateBuffer>(context, CL_MEM_READ_WRITE,
+                                                  bytes, nullptr)));
+  auto dst_buf = ok(adopt(check<::clCreateBuffer>(context, CL_MEM_READ_WRITE,
+                                                  bytes, nullptr)));
+
+  std::vector<std::byte> host(bytes);
+
+  auto gbps = [] (double bytes, std::chrono::duration<double> t) static {
+    return bytes / t.count() / 1e9;
+  };
+
+  microbench_results results{};
+
+  results.h2d_gbps = gbps(bytes, median_time(reps, [&] {
+    ok(check<::clEnqueueWriteBuffer>(queue, src_buf, CL_TRUE, 0, bytes,
+                                     host.data(), 0, nullptr, nullptr));
+  }));
+
+  results.d2h_gbps = gbps(bytes, median_time(reps, [&] {
+    ok(check<::clEnqueueReadBuffer>(queue, src_buf, CL_TRUE, 0, bytes,
+                                    host.data(), 0, nullptr, nullptr));
+  }));
+
+  results.d2d_gbps = gbps(2.0 * bytes, median_time(reps, [&] {
+    ok(check<::clEnqueueCopyBuffer>(queue, src_buf, dst_buf, 0, 0, bytes,
+                                    0, nullptr, nullptr));
+    ok(check<::clFinish>(queue));
+  }));
+
+  auto empty_kernel = ok(adopt(check<::clCreateKernel>(program, "empty")));
+
+  using usec_t = std::chrono::duration<double, std::micro>;
+
+  results.launch_latency_us = median_time<usec_t>(latency_reps, [&] {
+    const std::size_t one = 1;
+    ok(check<::clEnqueueNDRangeKernel>(queue, empty_kernel, 1, nullptr, &one, nullptr,
+                                       0, nullptr, nullptr));
+    ok(check<::clFinish>(queue));
+  }).count();
+
+  auto fma_kernel = ok(adopt(check<::clCreateKernel>(program, "fma_peak")));
+
+  const std::size_t items = bytes / sizeof(float);
+  const float a = 0.999f, b = 0.001f;
+
+  const ::cl_mem out = dst_buf;
+
+  ok(check<::clSetKernelArg>(fma_kernel, 0, sizeof(out), &out));
+  ok(check<::clSetKernelArg>(fma_kernel, 1, sizeof(a), &a));
+  ok(check<::clSetKernelArg>(fma_kernel, 2, sizeof(b), &b));
+
+  results.fp32_gflops = _microbench_flops_per_item * double(items) / 1e9
+                        / median_time(reps, [&] {
+    ok(check<::clEnqueueNDRangeKernel>(queue, fma_kernel, 1, nullptr, &items, nullptr,
+                                       0, nullptr, nullptr));
+    ok(check<::clFinish>(queue));
+  }).count();
+
+  return results;
+}
+
+//----------------------------------------------------------------------------------------
+// microbench_cache - on-disk results of microbenchmarks, keyed by device and driver
+//----------------------------------------------------------------------------------------
+//
+// Stored in `$XDG_CACHE_HOME/clapi/microbench` (`~/.cache/clapi/microbench` by default),
+// one file per device, thus benchmarks run once per machine and driver version.
+//
+// Note: Any I/O failure of cache is silently treated as miss. {{{
+//       Entries are written atomically, so concurrent writers (eg. two services
+//       starting together) never leave torn entry.
+// }}}
+
+class microbench_cache
+{
+public:
+  explicit microbench_cache(std::filesystem::path dir = default_directory()) :
+    _dir(std::move(dir))
+  {}
+
+  [[nodiscard]]
+  static auto default_directory() -> std::filesystem::path
+  {
+    return cache_directory("microbench");
+  }
+
+  // Whatever changes measured performance: device, its driver and platform
+  [[nodiscard]]
+  static auto key_of(const device_snapshot &d) -> std::string
+  {
+    runtime::platform p{d.platform};
+
+    return std::format("{}|{}|{}|{}|{}", d.vendor, d.name, d.driver_version,
+                       p.name(), p.version());
+  }
+
+  [[nodiscard]]
+  auto load(const device_snapshot &d) const -> std::optional<microbench_results>
+  {
+    auto key = key_of(d);
+
+    std::ifstream in{_path_of(key)};
+
+    std::string stored_key;
+    if (not std::getline(in, stored_key) or stored_key != key) return std::nullopt;
+
+    microbench_results r;
+
+    if (not (in >> r.h2d_gbps >> r.d2h_gbps >> r.d2d_gbps
+                >> r.launch_latency_us >> r.fp32_gflops))
+      return std::nullopt;
+
+    return r;
+  }
+
+  auto store(const device_snapshot &d, const microbench_results &r) const -> bool
+  {
+    auto key = key_of(d);
+
+    return write_file_atomically(_path_of(key),
+                                 std::format("{}\n{} {} {} {} {}\n", key,
+                                             r.h2d_gbps, r.d2h_gbps, r.d2d_gbps,
+                                             r.launch_latency_us, r.fp32_gflops));
+  }
+
+  [[nodiscard]]
+  auto directory() const noexcept -> const std::filesystem::path & { return _dir; }
+
+private:
+  // FNV-1a of the key, while the key itself is stored within for collisions
+  auto _path_of(std::string_view key) const -> std::filesystem::path
+  {
+    return _dir / (fnv1a_hex(fnv1a{}.update(key).value) + ".txt");
+  }
+
+  std::filesystem::path _dir;
+};
+
+//----------------------------------------------------------------------------------------
+// microbenchmarks - cached results, or runs (and caches) them
+//----------------------------------------------------------------------------------------
+
+[[nodiscard]]
+inline auto microbenchmarks(const device_snapshot &d,
+                            const microbench_cache &cache = microbench_cache{},
+                            bool rerun = false) -> microbench_results
+{
+  if (not rerun)
+    if (auto cached = cache.load(d)) return *cached;
+
+  auto results = run_microbenchmarks(d.device.id());
+  cache.store(d, results);
+
+  return results;
+}
+
+//----------------------------------------------------------------------------------------
+// cached_measurements - measurement source of `rank()`, never runs benchmarks
+//----------------------------------------------------------------------------------------
+
+struct cached_measurements
+{
+  microbench_cache cache{};
+
+  auto operator() (const device_snapshot &d) const -> device_measurements
+  {
+    if (auto cached = cache.load(d)) return cached->measurements();
+
+    return {};
+  }
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <new>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// numa_node_count - number of NUMA nodes of the host, as seen by the kernel
+//----------------------------------------------------------------------------------------
+//
+// Hosts w/o NUMA support (or not Linux) report a single node.
+
+[[nodiscard]]
+inline auto numa_node_count() -> unsigned
+{
+#if defined(__linux__)
+  namespace fs = std::filesystem;
+
+  std::error_code ec;
+  unsigned nodes = 0;
+
+  for (const auto &entry : fs::directory_iterator{"/sys/devices/system/node", ec})
+  {
+    auto name = entry.path().filename().native();
+
+    if (name.starts_with("node") and name.size() > 4
+        and name.find_first_not_of("0123456789", 4) == std::string::npos)
+      ++nodes;
+  }
+
+  return nodes != 0 ? nodes : 1;
+#else
+  return 1;
+#endif
+}
+
+//----------------------------------------------------------------------------------------
+// node_memory - host memory with pages bound to a single NUMA node
+//----------------------------------------------------------------------------------------
+//
+// Meant as backing storage (`CL_MEM_USE_HOST_PTR`) for buffers processed by
+// the sub-device of the same node, so work-items never reach over the interconnect.
+//
+// Note: Binding is a hint, never an error. {{{
+//       When `mbind` is unsupported (or not on Linux) memory is still allocated,
+//       `bound()` reports whether pages were actually bound.
+//
+//       Memory is page aligned, which also satisfies `CL_DEVICE_MEM_BASE_ADDR_ALIGN`
+//       for any device seen in wild, thus zero-copy on CPU devices.
+// }}}
+
+class node_memory
+{
+public:
+  node_memory() noexcept = default;
+
+  node_memory(std::size_t size, unsigned node) : _size(size), _node(node)
+  {
+    if (size == 0) return;
+
+#if defined(__linux__)
+    void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (p == MAP_FAILED) [[unlikely]]
+      throw std::bad_alloc{};
+
+    _data = static_cast<std::byte *>(p);
+    _bound = _bind(_data, size, node);
+#else
+    _data = static_cast<std::byte *>(::operator new(size, _page_align));
+#endif
+  }
+
+  node_memory(node_memory &&other) noexcept :
+    _data(std::exchange(other._data, nullptr)),
+    _size(std::exchange(other._size, 0)),
+    _node(other._node),
+    _bound(std::exchange(other._bound, false))
+  {}
+
+  auto operator=(node_memory &&other) noexcept -> node_memory &
+  {
+    if (this != &other)
+    {
+      _release();
+
+      _data = std::exchange(other._data, nullptr);
+      _size = std::exchange(other._size, 0);
+      _node = other._node;
+      _bound = std::exchange(other._bound, false);
+    }
+
+    return *this;
+  }
+
+  ~node_memory() { _release(); }
+
+  [[nodiscard]]
+  auto data() const noexcept -> std::byte * { return _data; }
+
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t { return _size; }
+
+  [[nodiscard]]
+  auto node() const noexcept -> unsigned { return _node; }
+
+  [[nodiscard]]
+  auto bound() const noexcept -> bool { return _bound; }
+
+  template <typename Ty_>
+  [[nodiscard]]
+  auto as_span() const noexcept -> std::span<Ty_>
+  {
+    return {reinterpret_cast<Ty_ *>(_data), _size / sizeof(Ty_)};
+  }
+
+private:
+#if defined(__linux__)
+  // <numaif.h> belongs to libnuma, we need just these
+  static constexpr int _mpol_bind = 2;
+  static constexpr unsigned _mpol_mf_move = 1u << 1;
+
+  static auto _bind(void *addr, std::size_t size, unsigned node) noexcept -> bool
+  {
+    constexpr unsigned bits = sizeof(unsigned long) * 8;
+
+    if (node >= bits) return false;
+
+    unsigned long mask = 1ul << node;
+
+    // The kernel reads `maxnode - 1` bits of the mask, sized as libnuma does
+    return ::syscall(SYS_mbind, addr, size, _mpol_bind, &mask, bits + 1,
+                     _mpol_mf_move) == 0;
+  }
+#else
+  static constexpr std::align_val_t _page_align{4096};
+#endif
+
+  auto _release() noexcept -> void
+  {
+    if (_data == nullptr) return;
+
+#if defined(__linux__)
+    ::munmap(_data, _size);
+#else
+    ::operator delete(_data, _page_align);
+#endif
+    _data = nullptr;
+  }
+
+  std::byte *_data = nullptr;
+  std::size_t _size = 0;
+  unsigned _node = 0;
+  bool _bound = false;
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// affinity_domain - `CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN` domains
+//----------------------------------------------------------------------------------------
+
+enum struct affinity_domain : ::cl_device_affinity_domain
+{
+  numa = CL_DEVICE_AFFINITY_DOMAIN_NUMA,
+  l4_cache = CL_DEVICE_AFFINITY_DOMAIN_L4_CACHE,
+  l3_cache = CL_DEVICE_AFFINITY_DOMAIN_L3_CACHE,
+  l2_cache = CL_DEVICE_AFFINITY_DOMAIN_L2_CACHE,
+  l1_cache = CL_DEVICE_AFFINITY_DOMAIN_L1_CACHE,
+  next_partitionable = CL_DEVICE_AFFINITY_DOMAIN_NEXT_PARTITIONABLE,
+};
+
+//----------------------------------------------------------------------------------------
+// sub_devices - owning set of sub-devices created by single partitioning
+//----------------------------------------------------------------------------------------
+//
+// Sub-devices are released on destruction. Order is the one reported by driver,
+// for partitioning by NUMA domain it's the order of nodes (at least for PoCL),
+// thus i-th sub-device is meant to be paired with memory of i-th node.
+
+class sub_devices
+{
+public:
+  sub_devices() noexcept = default;
+
+  explicit sub_devices(std::vector<::cl_device_id> ids) noexcept : _ids(std::move(ids)) {}
+
+  sub_devices(sub_devices &&other) noexcept : _ids(std::exchange(other._ids, {})) {}
+
+  auto operator=(sub_devices &&other) noexcept -> sub_devices &
+  {
+    if (this != &other)
+    {
+      _release();
+      _ids = std::exchange(other._ids, {});
+    }
+
+    return *this;
+  }
+
+  ~sub_devices() { _release(); }
+
+  [[nodiscard]]
+  auto ids() const noexcept -> std::span<const ::cl_device_id> { return _ids; }
+
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t { return _ids.size(); }
+
+  [[nodiscard]]
+  auto empty() const noexcept -> bool { return _ids.empty(); }
+
+  [[nodiscard]]
+  auto operator[](std::size_t i) const noexcept -> ::cl_device_id { return _ids[i]; }
+
+  [[nodiscard]]
+  auto begin() const noexcept { return _ids.begin(); }
+
+  [[nodiscard]]
+  auto end() const noexcept { return _ids.end(); }
+
+private:
+  auto _release() noexcept -> void
+  {
+    static constexpr auto releaseDevice = check<::clReleaseDevice>;
+
+    for (auto id : _ids) std::ignore = releaseDevice(id);
+
+    _ids.clear();
+  }
+
+  std::vector<::cl_device_id> _ids;
+};
+
+//----------------------------------------------------------------------------------------
+// partition capabilities of device
+//----------------------------------------------------------------------------------------
+
+[[nodiscard]]
+inline auto partition_max_sub_devices(::cl_device_id id) -> ::cl_uint
+{
+  return query_integral_property_<::clGetDeviceInfo, ::cl_uint>(
+    id, CL_DEVICE_PARTITION_MAX_SUB_DEVICES);
+}
+
+// Supported partitioning schemes, eg. CL_DEVICE_PARTITION_EQUALLY
+[[nodiscard]]
+inline auto partition_schemes(::cl_device_id id)
+  -> std::vector<::cl_device_partition_property>
+{
+  static constexpr auto getDeviceInfo = check<::clGetDeviceInfo>;
+
+  std::size_t bytes = 0;
+
+  if (auto r = getDeviceInfo(id, CL_DEVICE_PARTITION_PROPERTIES, 0, nullptr, &bytes);
+      !r) [[unlikely]]
+    throw r.error();
+
+  std::vector<::cl_device_partition_property> schemes(
+    bytes / sizeof(::cl_device_partition_property));
+
+  if (auto r = getDeviceInfo(id, CL_DEVICE_PARTITION_PROPERTIES,
+                             bytes, schemes.data(), nullptr);
+      !r) [[unlikely]]
+    throw r.error();
+
+  // Not partitionable device reports single 0
+  std::erase(schemes, 0);
+
+  return schemes;
+}
+
+[[nodiscard]]
+inline auto can_partition(::cl_device_id id, ::cl_device_partition_property scheme) -> bool
+{
+  return std::ranges::contains(partition_schemes(id), scheme);
+}
+
+[[nodiscard]]
+inline auto can_partition(::cl_device_id id, affinity_domain domain) -> bool
+{
+  if (not can_partition(id, CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN)) return false;
+
+  auto domains = query_integral_property_<::clGetDeviceInfo, ::cl_device_affinity_domain>(
+    id, CL_DEVICE_PARTITION_AFFINITY_DOMAIN);
+
+  return (domains & std::to_underlying(domain)) != 0;
+}
+
+} // namespace clapi::runtime
+
+namespace clapi::_detail::runtime
+{
+
+using namespace clapi::runtime;
+
+// `properties` are 0-terminated
+inline auto _create_sub_devices(::cl_device_id id,
+                                std::span<const ::cl_device_partition_property> properties)
+  -> sub_devices
+{
+  static constexpr auto createSubDevices = check<::clCreateSubDevices>;
+
+  ::cl_uint count = 0;
+
+  if (auto r = createSubDevices(id, properties.data(), 0, nullptr, &count); !r) [[unlikely]]
+    throw r.error();
+
+  std::vector<::cl_device_id> ids(count);
+
+  if (auto r = createSubDevices(id, properties.data(), count, ids.data(), &count);
+      !r) [[unlikely]]
+    throw r.error();
+
+  ids.resize(count);
+
+  return sub_devices{std::move(ids)};
+}
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// partition_by_affinity, partition_by_numa - one sub-device per cache or NUMA domain
+//----------------------------------------------------------------------------------------
+//
+// Throws `clapi::error_code_t` when device cannot be partitioned that way,
+// see `can_partition()`.
+
+[[nodiscard]]
+inline auto partition_by_affinity(::cl_device_id id, affinity_domain domain) -> sub_devices
+{
+  const ::cl_device_partition_property properties[] = {
+    CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN,
+    ::cl_device_partition_property(std::to_underlying(domain)),
+    0
+  };
+
+  return _detail::runtime::_create_sub_devices(id, properties);
+}
+
+[[nodiscard]]
+inline auto partition_by_numa(::cl_device_id id) -> sub_devices
+{
+  return partition_by_affinity(id, affinity_domain::numa);
+}
+
+//----------------------------------------------------------------------------------------
+// partition_equally - as many sub-devices of `units` compute units each as fits
+//----------------------------------------------------------------------------------------
+
+[[nodiscard]]
+inline auto partition_equally(::cl_device_id id, ::cl_uint units) -> sub_devices
+{
+  const ::cl_device_partition_property properties[] = {
+    CL_DEVICE_PARTITION_EQUALLY,
+    ::cl_device_partition_property(units),
+    0
+  };
+
+  return _detail::runtime::_create_sub_devices(id, properties);
+}
+
+//----------------------------------------------------------------------------------------
+// partition_by_counts - one sub-device of each of `counts` compute units
+//----------------------------------------------------------------------------------------
+
+[[nodiscard]]
+inline auto partition_by_counts(::cl_device_id id, std::span<const ::cl_uint> counts)
+  -> sub_devices
+{
+  std::vector<::cl_device_partition_property> properties;
+  properties.reserve(counts.size() + 3);
+
+  properties.push_back(CL_DEVICE_PARTITION_BY_COUNTS);
+  std::ranges::copy(counts
+                    | std::views::transform([] (::cl_uint c) static {
+                        return ::cl_device_partition_property(c);
+                      }),
+                    std::back_inserter(properties));
+  properties.push_back(CL_DEVICE_PARTITION_BY_COUNTS_LIST_END);
+  properties.push_back(0);
+
+  return _detail::runtime::_create_sub_devices(id, properties);
+}
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
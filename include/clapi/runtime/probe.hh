@@ -0,0 +1,129 @@
+#pragma once
+
+#include "clapi/runtime/worker_pool.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <vector>
+
+namespace clapi::_detail::runtime
+{
+
+template <typename Range_, typename Fn_>
+using _probe_result_t =
+  std::invoke_result_t<Fn_ &, const std::ranges::range_value_t<Range_> &>;
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// probe - fans `fn` over `items` on the worker pool, gathering results in input order
+//----------------------------------------------------------------------------------------
+//
+// Intended for the per-device driver round trips (property queries), where every item
+// is independent and the latency of each query dominates.
+//
+// Note: At most `pool.size()` items are probed at once, the calling thread blocks {{{
+//       until all of them are done.
+//
+//       Whenever any invocation throws, the exception of the first failing item
+//       (in input order) is rethrown, after all the others have completed.
+//
+//       Must not be called from within a job running on the same `pool`.
+// }}}
+
+template <std::ranges::input_range Range_, typename Fn_>
+  requires std::invocable<Fn_ &, const std::ranges::range_value_t<Range_> &>
+           and (not std::is_void_v<_detail::runtime::_probe_result_t<Range_, Fn_>>)
+[[nodiscard]]
+auto probe(worker_pool &pool, Range_ &&items, Fn_ &&fn)
+  -> std::vector<_detail::runtime::_probe_result_t<Range_, Fn_>>
+{
+  using std::vector, std::optional, std::exception_ptr;
+  using result_t = _detail::runtime::_probe_result_t<Range_, Fn_>;
+
+  // Workers index into inputs, thus those are remembered first.
+  auto inputs = std::forward<Range_>(items) | std::ranges::to<vector>();
+
+  const auto count = inputs.size();
+
+  if (count == 0) return {};
+
+  vector<optional<result_t>> results(count);
+  vector<exception_ptr> errors(count);
+
+  std::atomic<std::size_t> next{0};
+
+  const auto nworkers = std::min<std::size_t>(count, pool.size());
+  std::latch done{std::ptrdiff_t(nworkers)};
+
+  // Each of workers pulls next unprobed item, until there are none left.
+  auto worker = [&] noexcept {
+    for (auto i = next.fetch_add(1, std::memory_order_relaxed);
+         i < count;
+         i = next.fetch_add(1, std::memory_order_relaxed))
+    {
+      try {
+        results[i].emplace(std::invoke(fn, std::as_const(inputs[i])));
+      }
+      catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+
+    done.count_down();
+  };
+
+  for (std::size_t w = 0; w < nworkers; ++w) pool.post(worker);
+
+  done.wait();
+
+  auto is_failed = [] (const exception_ptr &e) static { return bool(e); };
+
+  if (auto failed = std::ranges::find_if(errors, is_failed);
+      failed != errors.end()) [[unlikely]]
+    std::rethrow_exception(*failed);
+
+  return std::move(results)
+         | std::views::as_rvalue
+         | std::views::transform([] (optional<result_t> &&r) {
+             return *std::move(r);
+           })
+         | std::ranges::to<vector>();
+}
+
+//----------------------------------------------------------------------------------------
+// probe - as above, on the transient pool of at most `max_workers` threads
+//----------------------------------------------------------------------------------------
+
+template <std::ranges::input_range Range_, typename Fn_>
+  requires std::invocable<Fn_ &, const std::ranges::range_value_t<Range_> &>
+           and (not std::is_void_v<_detail::runtime::_probe_result_t<Range_, Fn_>>)
+[[nodiscard]]
+auto probe(Range_ &&items,
+           Fn_ &&fn,
+           unsigned max_workers = worker_pool::default_concurrency())
+  -> std::vector<_detail::runtime::_probe_result_t<Range_, Fn_>>
+{
+  auto inputs = std::forward<Range_>(items) | std::ranges::to<std::vector>();
+
+  if (inputs.empty()) return {};
+
+  worker_pool pool{unsigned(std::min<std::size_t>(inputs.size(), max_workers))};
+
+  return probe(pool, std::move(inputs), std::forward<Fn_>(fn));
+}
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
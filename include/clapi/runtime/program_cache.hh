@@ -0,0 +1,302 @@
+#pragma once
+
+#include "clapi/etc/basic.hh"
+#include "clapi/runtime/device.hh"
+#include "clapi/runtime/disk_cache.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+struct program_cache_stats
+{
+  std::uint64_t hits;
+  std::uint64_t misses;
+  std::uint64_t rejected;   // cached binaries refused by the driver, then rebuilt
+  std::uint64_t stored;
+  std::uint64_t evicted;
+
+  [[nodiscard]]
+  auto hit_rate() const noexcept -> double
+  {
+    auto total = hits + misses;
+    return total ? double(hits) / double(total) : 0.0;
+  }
+};
+
+//----------------------------------------------------------------------------------------
+// program_cache - on-disk cache of built program binaries
+//----------------------------------------------------------------------------------------
+//
+// Programs are keyed by hash of the source, build options, device name, driver version
+// and platform (name and version). The first build from source stores
+// `CL_PROGRAM_BINARIES` in `$XDG_CACHE_HOME/clapi/programs`, later builds load them
+// by `clCreateProgramWithBinary`.
+//
+// Note: Binary refused by the driver (or failing to build) is removed and {{{
+//       the program is rebuilt from the source, so stale entries heal themselves.
+//
+//       Directory is trimmed to `max_bytes` after each store, removing least recently
+//       used entries (each hit refreshes modification time of its file).
+//
+//       Failure to build from the source throws `clapi::error_code_t`.
+// }}}
+
+class program_cache : immovable<program_cache>
+{
+public:
+  static constexpr std::uintmax_t default_max_bytes = std::uintmax_t(256) << 20;
+
+  explicit program_cache(std::filesystem::path dir = cache_directory("programs"),
+                         std::uintmax_t max_bytes = default_max_bytes) :
+    _dir(std::move(dir)), _max_bytes(max_bytes)
+  {}
+
+  [[nodiscard]]
+  auto build(::cl_context ctx,
+             ::cl_device_id dev,
+             std::string_view source,
+             std::string_view options = {}) -> program_handle
+  {
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    const auto key = key_of(dev, source, options);
+    const auto path = _path_of(key);
+
+    if (auto binary = _load(path, key))
+    {
+      if (auto program = _from_binary(ctx, dev, *binary, options)) [[likely]]
+      {
+        _hits.fetch_add(1, relaxed);
+        touch(path);
+
+        return std::move(*program);
+      }
+
+      _rejected.fetch_add(1, relaxed);
+
+      std::error_code ec;
+      std::filesystem::remove(path, ec);
+    }
+
+    _misses.fetch_add(1, relaxed);
+
+    auto program = _from_source(ctx, dev, source, options);
+
+    if (auto binary = _binary_of(program, dev); not binary.empty())
+      _store(path, key, binary);
+
+    return program;
+  }
+
+  [[nodiscard]]
+  static auto key_of(::cl_device_id dev, std::string_view source, std::string_view options)
+    -> std::uint64_t
+  {
+    runtime::device d{dev};
+    auto p = d.platform();
+
+    return fnv1a{}
+      .update(source)
+      .update(options)
+      .update(d.name())
+      .update(d.driver_version())
+      .update(p.name())
+      .update(p.version())
+      .value;
+  }
+
+  [[nodiscard]]
+  auto stats() const noexcept -> program_cache_stats
+  {
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    return {
+      .hits = _hits.load(relaxed),
+      .misses = _misses.load(relaxed),
+      .rejected = _rejected.load(relaxed),
+      .stored = _stored.load(relaxed),
+      .evicted = _evicted.load(relaxed),
+    };
+  }
+
+  [[nodiscard]]
+  auto directory() const noexcept -> const std::filesystem::path & { return _dir; }
+
+private:
+  // File starts with the magic and the key, followed by the binary
+  static constexpr std::array<char, 8> _magic = {'C', 'L', 'A', 'P', 'I', 'P', 'B', '1'};
+
+  auto _path_of(std::uint64_t key) const -> std::filesystem::path
+  {
+    return _dir / (fnv1a_hex(key) + ".bin");
+  }
+
+  static auto _load(const std::filesystem::path &path, std::uint64_t key)
+    -> std::optional<std::vector<unsigned char>>
+  {
+    std::ifstream in{path, std::ios::binary};
+
+    std::array<char, _magic.size()> magic;
+    std::uint64_t stored_key;
+
+    if (not in.read(magic.data(), magic.size())
+        or not in.read(reinterpret_cast<char *>(&stored_key), sizeof(stored_key))
+        or magic != _magic
+        or stored_key != key)
+      return std::nullopt;
+
+    std::vector<unsigned char> binary(std::istreambuf_iterator<char>{in}, {});
+
+    if (binary.empty()) return std::nullopt;
+
+    return binary;
+  }
+
+  auto _store(const std::filesystem::path &path,
+              std::uint64_t key,
+              std::span<const unsigned char> binary) -> void
+  {
+    const std::span<const std::byte> parts[] = {
+      std::as_bytes(std::span{_magic}),
+      std::as_bytes(std::span{&key, 1}),
+      std::as_bytes(binary),
+    };
+
+    if (not write_file_atomically(path, parts)) return;
+
+    _stored.fetch_add(1, std::memory_order_relaxed);
+    _evicted.fetch_add(evict_least_recently_used(_dir, _max_bytes),
+                       std::memory_order_relaxed);
+  }
+
+  static auto _from_binary(::cl_context ctx,
+                           ::cl_device_id dev,
+                           std::span<const unsigned char> binary,
+                           std::string_view options) -> std::optional<program_handle>
+  {
+    using clapi::ExpectedFailure;
+
+    const std::size_t size = binary.size();
+    const unsigned char *data = binary.data();
+    ::cl_int status = CL_SUCCESS;
+
+    auto program = adopt(check<::clCreateProgramWithBinary>(ExpectedFailure, ctx, 1, &dev,
+                                                            &size, &data, &status));
+
+    if (not program or status != CL_SUCCESS) [[unlikely]] return std::nullopt;
+
+    if (not _build(*program, dev, options, true)) [[unlikely]] return std::nullopt;
+
+    return *std::move(program);
+  }
+
+  static auto _from_source(::cl_context ctx,
+                           ::cl_device_id dev,
+                           std::string_view source,
+                           std::string_view options) -> program_handle
+  {
+    const char *text = source.data();
+    const std::size_t size = source.size();
+
+    auto program = adopt(check<::clCreateProgramWithSource>(ctx, 1, &text, &size));
+
+    if (not program) [[unlikely]] throw program.error();
+
+    if (auto built = _build(*program, dev, options, false); not built) [[unlikely]]
+      throw built.error();
+
+    return *std::move(program);
+  }
+
+  static auto _build(::cl_program program,
+                     ::cl_device_id dev,
+                     std::string_view options,
+                     bool expect_failure) -> error_or<>
+  {
+    // Options must be null-terminated
+    std::string opts{options};
+
+    if (expect_failure)
+      return check<::clBuildProgram>(clapi::ExpectedFailure, program, 1, &dev,
+                                     opts.c_str(), nullptr, nullptr);
+
+    return check<::clBuildProgram>(program, 1, &dev, opts.c_str(), nullptr, nullptr);
+  }
+
+  // Binary for `dev`, among those of all devices of the program (its context)
+  static auto _binary_of(::cl_program program, ::cl_device_id dev)
+    -> std::vector<unsigned char>
+  {
+    ::cl_uint count = 0;
+
+    if (not check<::clGetProgramInfo>(program, CL_PROGRAM_NUM_DEVICES,
+                                      sizeof(count), &count, nullptr)
+        or count == 0)
+      return {};
+
+    std::vector<::cl_device_id> devices(count);
+
+    if (not check<::clGetProgramInfo>(program, CL_PROGRAM_DEVICES,
+                                      count * sizeof(::cl_device_id), devices.data(),
+                                      nullptr))
+      return {};
+
+    auto of_dev = std::ranges::find(devices, dev);
+    if (of_dev == devices.end()) return {};
+
+    const auto index = std::size_t(of_dev - devices.begin());
+
+    std::vector<std::size_t> sizes(count);
+
+    if (not check<::clGetProgramInfo>(program, CL_PROGRAM_BINARY_SIZES,
+                                      count * sizeof(std::size_t), sizes.data(), nullptr)
+        or sizes[index] == 0)
+      return {};
+
+    // Binaries of other devices are skipped (null destination)
+    std::vector<unsigned char> binary(sizes[index]);
+    std::vector<unsigned char *> data(count, nullptr);
+    data[index] = binary.data();
+
+    if (not check<::clGetProgramInfo>(program, CL_PROGRAM_BINARIES,
+                                      count * sizeof(unsigned char *), data.data(),
+                                      nullptr))
+      return {};
+
+    return binary;
+  }
+
+  std::filesystem::path _dir;
+  std::uintmax_t _max_bytes;
+
+  std::atomic<std::uint64_t> _hits{0};
+  std::atomic<std::uint64_t> _misses{0};
+  std::atomic<std::uint64_t> _rejected{0};
+  std::atomic<std::uint64_t> _stored{0};
+  std::atomic<std::uint64_t> _evicted{0};
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
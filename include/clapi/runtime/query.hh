@@ -0,0 +1,183 @@
+#pragma once
+
+#include "clapi/transforms/error_returns.hh"
+#include "clapi/runtime/intern.hh"
+
+#include <CL/cl.h>
+
+#include <array>
+#include <concepts>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace clapi::runtime
+{
+
+template <auto Fn_>
+  requires clapi::deduced::plain_function_pointer<Fn_>
+           and clapi::deduced::core_api<nontype_t<Fn_>>
+constexpr inline auto check = transforms::check_fn(nontype<Fn_>);
+
+// An example of using the wrapper `clapi::transforms::check` functor: {{{
+
+/*
+
+``` c++
+template <auto Fn_>
+  requires clapi::deduced::plain_function_pointer<Fn_>
+           and clapi::deduced::core_api<nontype_t<Fn_>>
+[[nodiscard]]
+auto checked(auto &&...args) noexcept
+{
+  return check<Fn_>(clapi::fwd_opt<decltype(args)>(args)...);
+}
+```
+}}}
+*/
+
+constexpr inline auto DevInfo = nontype<::clGetDeviceInfo>;
+constexpr inline auto PlatInfo = nontype<::clGetPlatformInfo>;
+
+} // namespace clapi::runtime
+
+namespace clapi::runtime::inline query_prop
+{
+
+template <auto Fn_,
+         typename IdTy_,
+         typename PropTy_>
+concept clapi_query_function =
+  std::is_invocable_r_v<::cl_int,
+                        decltype(Fn_),
+                        IdTy_,
+                        PropTy_,
+                        ::size_t,
+                        void*,
+                        ::size_t*>;
+
+
+template <auto Fn_, typename PropTy_>
+auto query_string_property_(auto id, PropTy_ prop) -> std::string
+  requires clapi_query_function<Fn_, decltype(id), PropTy_>
+{
+   using std::string;
+
+   ::size_t req_capacity;
+
+   constexpr transforms::check_fn<Fn_> query;
+   error_or<> r = query(id, prop, 0, nullptr, &req_capacity);
+
+   if (!r) throw r.error();
+
+   // XXX: C++ requires null-terminated data since c++-11
+   // Code around won't work for anything that out-dated.
+   // But for sake of backporting...
+   static_assert(__cplusplus >= 201103L,
+                 "c++11 and later requires std::basic_string<char>::data()"
+                 " to have space for '\\0';\n"
+                 " This implementation takes it into account");
+
+   string ret(req_capacity-1, '\0'); // Note: -1, please see above for explaination.
+
+   r = query(id, prop, ret.size()+1, ret.data(), nullptr);
+   if (!r) [[unlikely]] throw r.error();
+
+   return ret;
+}
+
+template <auto Fn_, typename PropTy_>
+auto query_string_property_(nontype_t<Fn_>, auto id, PropTy_ prop) -> std::string
+  requires clapi_query_function<Fn_, decltype(id), PropTy_>
+{
+  return query_string_property_<Fn_>(id, prop);
+}
+
+// Identity strings (names, vendors, versions) are few and short, those are queried
+// into the stack buffer whenever they fit and interned without any std::string.
+template <auto Fn_, typename PropTy_>
+auto query_interned_property_(auto id, PropTy_ prop) -> interned
+  requires clapi_query_function<Fn_, decltype(id), PropTy_>
+{
+   ::size_t req_capacity;
+
+   constexpr transforms::check_fn<Fn_> query;
+   error_or<> r = query(id, prop, 0, nullptr, &req_capacity);
+
+   if (!r) throw r.error();
+
+   if (std::array<char, 256> buf; req_capacity <= buf.size()) [[likely]]
+   {
+     r = query(id, prop, buf.size(), buf.data(), nullptr);
+     if (!r) [[unlikely]] throw r.error();
+
+     // Note: -1, since req_capacity accounts for '\0'
+     return intern(std::string_view{buf.data(), req_capacity - 1});
+   }
+
+   return intern(query_string_property_<Fn_>(id, prop));
+}
+
+template <auto Fn_, typename PropTy_>
+auto query_interned_property_(nontype_t<Fn_>, auto id, PropTy_ prop) -> interned
+  requires clapi_query_function<Fn_, decltype(id), PropTy_>
+{
+  return query_interned_property_<Fn_>(id, prop);
+}
+
+template <auto Fn_,
+         std::integral Ty_,
+         typename ObjTy_,
+         typename PropTy_>
+  requires clapi_query_function<Fn_, ObjTy_, PropTy_>
+auto query_integral_property_(ObjTy_ id, PropTy_ prop) -> Ty_
+{
+  Ty_ value;
+
+  auto r = check<Fn_>(id, prop, sizeof(value), &value, nullptr);
+
+  if (!r) [[unlikely]] throw r.error();
+
+  return value;
+}
+
+template <auto Fn_, std::integral Ty_, typename ObjTy_, typename PropTy_>
+  requires clapi_query_function<Fn_, ObjTy_, PropTy_>
+auto query_integral_property_(nontype_t<Fn_>, ObjTy_ id, PropTy_ prop) -> Ty_
+{
+  [[clapi_inline_stmt]]
+  return query_integral_property_<Fn_, Ty_>(id, prop);
+}
+
+template <auto Fn_, typename ObjTy_, typename PropTy_>
+  requires clapi_query_function<Fn_, ObjTy_, ::cl_bool>
+[[nodiscard]]
+auto query_bool_property_(ObjTy_ o, PropTy_ p) -> bool
+{
+  [[clapi_inline_stmt]]
+  return query_integral_property_<Fn_, cl_bool>(o, p);
+}
+
+template <auto Fn_, typename ObjTy_, typename PropTy_>
+  requires clapi_query_function<Fn_, ObjTy_, ::cl_bool>
+[[nodiscard]]
+auto query_bool_property_(nontype_t<Fn_>, ObjTy_ o, PropTy_ p) -> bool
+{
+  [[clapi_inline_stmt]]
+  return query_integral_property_<Fn_, cl_bool>(o, p);
+}
+
+template <auto Fn_, typename ObjTy_, typename PropTy_>
+  requires clapi_query_function<Fn_, ObjTy_, ::cl_bool>
+[[nodiscard]]
+auto query_bool_property(nontype_t<Fn_>, ObjTy_ o, PropTy_ p) -> bool
+{
+  [[clapi_inline_stmt]]
+  return query_bool_property_<Fn_>(o, p);
+}
+
+} // namespace clapi::runtime::inline query_prop
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
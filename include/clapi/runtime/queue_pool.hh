@@ -0,0 +1,351 @@
+#pragma once
+
+#include "clapi/etc/basic.hh"
+#include "clapi/runtime/device_group.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+class queue_pool;
+
+struct queue_pool_options
+{
+  // Upper bound of queues (idle and leased) per device
+  unsigned max_per_device = 8;
+};
+
+struct queue_pool_stats
+{
+  std::uint64_t acquires;
+  std::uint64_t hits;       // served by warm queue
+  std::uint64_t misses;     // had to create the queue
+  std::uint64_t waits;      // had to wait for queue to be returned (contention)
+  std::uint64_t evictions;  // idle queue of other properties released to make room
+  std::uint64_t discarded;  // returned queues failing to drain
+
+  [[nodiscard]]
+  auto miss_rate() const noexcept -> double
+  {
+    return acquires ? double(misses) / double(acquires) : 0.0;
+  }
+};
+
+//----------------------------------------------------------------------------------------
+// queue_lease - exclusive use of the pooled queue, returned to the pool on destruction
+//----------------------------------------------------------------------------------------
+//
+// Returned queue is drained (`clFinish`) first, so the next leaseholder starts with
+// an empty queue. Queue failing to drain is released rather than returned.
+
+class queue_lease
+{
+public:
+  queue_lease() noexcept = default;
+
+  queue_lease(queue_lease &&other) noexcept :
+    _pool(std::exchange(other._pool, nullptr)),
+    _device(other._device),
+    _properties(other._properties),
+    _queue(std::move(other._queue))
+  {}
+
+  auto operator=(queue_lease &&other) noexcept -> queue_lease &
+  {
+    queue_lease{std::move(other)}.swap(*this);
+    return *this;
+  }
+
+  ~queue_lease();
+
+  [[nodiscard]]
+  auto get() const noexcept -> ::cl_command_queue { return _queue.get(); }
+
+  operator ::cl_command_queue() const noexcept { return _queue.get(); }
+
+  explicit operator bool() const noexcept { return bool(_queue); }
+
+  [[nodiscard]]
+  auto device() const noexcept -> ::cl_device_id { return _device; }
+
+  auto swap(queue_lease &other) noexcept -> void
+  {
+    std::swap(_pool, other._pool);
+    std::swap(_device, other._device);
+    std::swap(_properties, other._properties);
+    _queue.swap(other._queue);
+  }
+
+private:
+  friend queue_pool;
+
+  queue_lease(queue_pool *pool,
+              ::cl_device_id dev,
+              ::cl_command_queue_properties properties,
+              queue_handle queue) noexcept :
+    _pool(pool), _device(dev), _properties(properties), _queue(std::move(queue))
+  {}
+
+  queue_pool *_pool = nullptr;
+  ::cl_device_id _device = nullptr;
+  ::cl_command_queue_properties _properties = 0;
+  queue_handle _queue;
+};
+
+//----------------------------------------------------------------------------------------
+// queue_pool - warm command queues (and contexts) per device
+//----------------------------------------------------------------------------------------
+//
+// Queues are kept per (device, properties) and leased to threads by `acquire()`.
+// Contexts are created per device on the first use, unless given by `device_group`.
+//
+// Note: When the device reached `max_per_device` queues, `acquire()` {{{
+//       evicts idle queue of other properties if there is any, otherwise waits
+//       for a lease to be returned. `try_acquire()` never waits.
+//
+//       Driver calls (create, finish, release) are never made under the lock.
+//       The pool must outlive all of its leases.
+// }}}
+
+class queue_pool : immovable<queue_pool>
+{
+public:
+  explicit queue_pool(queue_pool_options options = {}) : _options(options) {}
+
+  // Reuses contexts of the group
+  explicit queue_pool(const device_group &group, queue_pool_options options = {}) :
+    queue_pool(options)
+  {
+    for (const auto &m : group.members())
+      if (auto ctx = context_handle::retain(m.context)) [[likely]]
+        _contexts.emplace(m.device.id(), *std::move(ctx));
+  }
+
+  [[nodiscard]]
+  auto acquire(::cl_device_id dev, ::cl_command_queue_properties properties = 0)
+    -> queue_lease
+  {
+    return *_acquire(dev, properties, true);
+  }
+
+  [[nodiscard]]
+  auto try_acquire(::cl_device_id dev, ::cl_command_queue_properties properties = 0)
+    -> std::optional<queue_lease>
+  {
+    return _acquire(dev, properties, false);
+  }
+
+  [[nodiscard]]
+  auto stats() const noexcept -> queue_pool_stats
+  {
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    return {
+      .acquires = _acquires.load(relaxed),
+      .hits = _hits.load(relaxed),
+      .misses = _misses.load(relaxed),
+      .waits = _waits.load(relaxed),
+      .evictions = _evictions.load(relaxed),
+      .discarded = _discarded.load(relaxed),
+    };
+  }
+
+  // Number of idle queues kept warm
+  [[nodiscard]]
+  auto idle() const -> std::size_t
+  {
+    std::scoped_lock lock{_mutex};
+
+    std::size_t n = 0;
+    for (const auto &[_, queues] : _idle) n += queues.size();
+
+    return n;
+  }
+
+private:
+  friend queue_lease;
+
+  using key_t = std::pair<::cl_device_id, ::cl_command_queue_properties>;
+
+  auto _acquire(::cl_device_id dev, ::cl_command_queue_properties properties, bool wait)
+    -> std::optional<queue_lease>
+  {
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    _acquires.fetch_add(1, relaxed);
+
+    queue_handle evicted;
+    bool waited = false;
+
+    std::unique_lock lock{_mutex};
+
+    for (;;)
+    {
+      if (auto &warm = _idle[{dev, properties}]; not warm.empty()) [[likely]]
+      {
+        auto q = std::move(warm.back());
+        warm.pop_back();
+
+        _hits.fetch_add(1, relaxed);
+        return queue_lease{this, dev, properties, std::move(q)};
+      }
+
+      if (auto &live = _live[dev]; live < std::max(1u, _options.max_per_device))
+      {
+        ++live;
+        break;
+      }
+
+      // Room is taken by idle queue of other properties
+      if (auto victim = std::ranges::find_if(_idle, [dev] (const auto &kv) {
+            return kv.first.first == dev and not kv.second.empty();
+          });
+          victim != _idle.end())
+      {
+        evicted = std::move(victim->second.back());
+        victim->second.pop_back();
+
+        _evictions.fetch_add(1, relaxed);
+        break;
+      }
+
+      if (not wait) return std::nullopt;
+
+      if (not std::exchange(waited, true)) _waits.fetch_add(1, relaxed);
+
+      _returned.wait(lock);
+    }
+
+    lock.unlock();
+
+    // Eviction leaves `live` as is, the slot passes to the new queue.
+    evicted.reset();
+
+    _misses.fetch_add(1, relaxed);
+
+    try {
+      return queue_lease{this, dev, properties, _create(dev, properties)};
+    }
+    catch (...) {
+      _forget(dev);
+      throw;
+    }
+  }
+
+  auto _create(::cl_device_id dev, ::cl_command_queue_properties properties)
+    -> queue_handle
+  {
+    const ::cl_queue_properties list[] = {
+      CL_QUEUE_PROPERTIES, ::cl_queue_properties(properties),
+      0
+    };
+
+    auto q = adopt(check<::clCreateCommandQueueWithProperties>(
+      _context_of(dev), dev, properties ? list : nullptr));
+
+    if (!q) [[unlikely]] throw q.error();
+
+    return *std::move(q);
+  }
+
+  auto _context_of(::cl_device_id dev) -> ::cl_context
+  {
+    {
+      std::scoped_lock lock{_mutex};
+
+      if (auto it = _contexts.find(dev); it != _contexts.end()) [[likely]]
+        return it->second.get();
+    }
+
+    auto ctx = adopt(check<::clCreateContext>(nullptr, 1, &dev, nullptr, nullptr));
+
+    if (!ctx) [[unlikely]] throw ctx.error();
+
+    std::scoped_lock lock{_mutex};
+
+    // Whoever was the first wins, ours is released otherwise
+    return _contexts.try_emplace(dev, *std::move(ctx)).first->second.get();
+  }
+
+  // Queue of the device won't come back
+  auto _forget(::cl_device_id dev) noexcept -> void
+  {
+    {
+      std::scoped_lock lock{_mutex};
+
+      // Counted by the acquire, thus never missing
+      if (auto live = _live.find(dev); live != _live.end()) --live->second;
+    }
+
+    _returned.notify_all();
+  }
+
+  auto _discard(::cl_device_id dev, queue_handle queue) noexcept -> void
+  {
+    _discarded.fetch_add(1, std::memory_order_relaxed);
+    queue.reset();
+
+    _forget(dev);
+  }
+
+  auto _return(::cl_device_id dev,
+               ::cl_command_queue_properties properties,
+               queue_handle queue) noexcept -> void
+  {
+    if (not check<::clFinish>(queue)) [[unlikely]] return _discard(dev, std::move(queue));
+
+    // Failed insertion leaves the queue as is (strong guarantee), it's released then
+    try {
+      std::scoped_lock lock{_mutex};
+      _idle[{dev, properties}].push_back(std::move(queue));
+    }
+    catch (const std::bad_alloc &) {
+      return _discard(dev, std::move(queue));
+    }
+
+    // Waiters might be of other devices, or other properties (to evict that one)
+    _returned.notify_all();
+  }
+
+  queue_pool_options _options;
+
+  mutable std::mutex _mutex;
+  std::condition_variable _returned;
+
+  std::map<::cl_device_id, context_handle> _contexts;
+  std::map<key_t, std::vector<queue_handle>> _idle;
+  std::map<::cl_device_id, unsigned> _live;
+
+  std::atomic<std::uint64_t> _acquires{0};
+  std::atomic<std::uint64_t> _hits{0};
+  std::atomic<std::uint64_t> _misses{0};
+  std::atomic<std::uint64_t> _waits{0};
+  std::atomic<std::uint64_t> _evictions{0};
+  std::atomic<std::uint64_t> _discarded{0};
+};
+
+inline queue_lease::~queue_lease()
+{
+  if (_pool and _queue) _pool->_return(_device, _properties, std::move(_queue));
+}
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,319 @@
+#pragma once
+
+#include "clapi/etc/basic.hh"
+#include "clapi/runtime/device.hh"
+#include "clapi/runtime/discovery.hh"
+#include "clapi/runtime/enumerate.hh"
+#include "clapi/runtime/intern.hh"
+#include "clapi/runtime/probe.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// platform_snapshot, device_snapshot - immutable copies of the discovered properties
+//----------------------------------------------------------------------------------------
+
+struct platform_snapshot
+{
+  ::cl_platform_id id;
+
+  interned name;
+  interned vendor;
+  interned version;
+  interned profile;
+};
+
+struct device_snapshot
+{
+  runtime::device device;
+  ::cl_platform_id platform;
+  ::cl_device_type type;
+
+  interned name;
+  interned vendor;
+  interned version;
+  interned driver_version;
+  interned profile;
+
+  std::optional<::cl_version> numeric_version;
+
+  bool available;
+
+  ::cl_uint compute_units;
+  ::cl_uint max_clock_mhz;
+  ::cl_ulong global_mem_size;
+  ::cl_ulong max_mem_alloc_size;
+  std::size_t mem_base_addr_align;
+
+  bool host_unified_memory;
+  bool fp64;
+  bool fp16;
+
+  [[nodiscard]]
+  auto full_id() const noexcept -> full_device_id_t
+  {
+    return {platform, device.id(), type};
+  }
+};
+
+//----------------------------------------------------------------------------------------
+// registry_snapshot - the published, never changing, state of `device_registry`
+//----------------------------------------------------------------------------------------
+
+struct registry_snapshot
+{
+  // Unique across all of registries, increasing with each publication
+  std::uint64_t generation;
+
+  std::vector<platform_snapshot> platforms;
+  std::vector<device_snapshot> devices;
+
+  [[nodiscard]]
+  auto find(::cl_device_id id) const noexcept -> const device_snapshot *
+  {
+    auto it = std::ranges::find(devices, id, [] (const device_snapshot &d) {
+      return d.device.id();
+    });
+
+    return it != devices.end() ? &*it : nullptr;
+  }
+
+  [[nodiscard]]
+  auto find(::cl_platform_id id) const noexcept -> const platform_snapshot *
+  {
+    auto it = std::ranges::find(platforms, id, &platform_snapshot::id);
+
+    return it != platforms.end() ? &*it : nullptr;
+  }
+
+  // Devices of given type (any of type bits), in the discovery order
+  [[nodiscard]]
+  auto devices_of(::cl_device_type type) const
+  {
+    return devices | std::views::filter([type] (const device_snapshot &d) {
+      return (d.type & type) != 0;
+    });
+  }
+
+  // Interned, thus it's just handle compare per device
+  [[nodiscard]]
+  auto devices_named(interned name) const
+  {
+    return devices | std::views::filter([name] (const device_snapshot &d) {
+      return d.name == name;
+    });
+  }
+};
+
+//----------------------------------------------------------------------------------------
+// device_registry - process-wide registry of discovered platforms and devices
+//----------------------------------------------------------------------------------------
+//
+// Readers never call the driver, they look devices up in the published
+// `registry_snapshot`, which is swapped atomically as whole by `refresh()`/`publish()`.
+//
+// Note: Two flavours of read access: {{{
+//
+//  - `snapshot()` - shares ownership of the current snapshot, one can keep it as long
+//                   as needed.
+//
+//  - `current()`  - RCU-like read, w/o any lock nor reference counting, as long as
+//                   there was no publication since the last read from the same thread.
+//                   The reference stays valid until the next call of `current()` from
+//                   the same thread.
+//
+// The first read of empty registry populates it by `refresh()`.
+//
+// Availability of devices is queried anew by each refresh, while the rest of
+// properties comes from (memoizing) device proxies.
+// }}}
+
+class device_registry : immovable<device_registry>
+{
+public:
+  using snapshot_ptr = std::shared_ptr<const registry_snapshot>;
+
+  [[nodiscard]]
+  static auto instance() -> device_registry &
+  {
+    static device_registry registry;
+    return registry;
+  }
+
+  [[nodiscard]]
+  auto snapshot() -> snapshot_ptr
+  {
+    if (auto s = _current.load(std::memory_order_acquire)) [[likely]]
+      return s;
+
+    // Concurrent first readers shall not enumerate all at once
+    std::call_once(_populated, [this] {
+      if (not _current.load(std::memory_order_acquire)) refresh();
+    });
+
+    return _current.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]]
+  auto current() -> const registry_snapshot &
+  {
+    struct cached_t
+    {
+      const device_registry *owner = nullptr;
+      std::uint64_t generation = 0;
+      snapshot_ptr snapshot;
+    };
+
+    thread_local cached_t cached;
+
+    if (cached.owner == this
+        and cached.generation == _generation.load(std::memory_order_acquire)) [[likely]]
+      return *cached.snapshot;
+
+    cached.snapshot = snapshot();
+    cached.owner = this;
+    cached.generation = cached.snapshot->generation;
+
+    return *cached.snapshot;
+  }
+
+  // Enumerates everything anew, then publishes it.
+  auto refresh() -> snapshot_ptr
+  {
+    discovery_service discovery;
+    return publish(discovery.get());
+  }
+
+  // Snapshot of already discovered platforms and devices, for the caller only
+  [[nodiscard]]
+  static auto take_snapshot(const discovery_result &found) -> registry_snapshot
+  {
+    return take_snapshot(found.platforms, found.devices);
+  }
+
+  [[nodiscard]]
+  static auto take_snapshot(std::span<const ::cl_platform_id> platforms,
+                            std::span<const full_device_id_t> devices) -> registry_snapshot
+  {
+    return {
+      .generation = _next_generation(),
+      .platforms = platforms
+                   | std::views::transform(_snapshot_platform)
+                   | std::ranges::to<std::vector>(),
+      .devices = probe(devices, _snapshot_or_unavailable),
+    };
+  }
+
+  // Publishes snapshot of already discovered platforms and devices
+  auto publish(const discovery_result &found) -> snapshot_ptr
+  {
+    return publish(found.platforms, found.devices);
+  }
+
+  auto publish(std::span<const ::cl_platform_id> platforms,
+               std::span<const full_device_id_t> devices) -> snapshot_ptr
+  {
+    std::scoped_lock lock{_publishing};
+
+    snapshot_ptr published = std::make_shared<registry_snapshot>(take_snapshot(platforms,
+                                                                               devices));
+
+    _current.store(published, std::memory_order_release);
+    _generation.store(published->generation, std::memory_order_release);
+
+    return published;
+  }
+
+private:
+  static auto _next_generation() noexcept -> std::uint64_t
+  {
+    static std::atomic<std::uint64_t> generation{0};
+    return generation.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  static auto _snapshot_platform(::cl_platform_id id) -> platform_snapshot
+  {
+    runtime::platform p{id};
+
+    return {
+      .id = id,
+      .name = p.name(),
+      .vendor = p.vendor(),
+      .version = p.version(),
+      .profile = p.profile(),
+    };
+  }
+
+  static auto _snapshot_device(const full_device_id_t &full_id) -> device_snapshot
+  {
+    runtime::device d{full_id};
+
+    auto version = d.numeric_version();
+
+    return {
+      .device = d,
+      .platform = d.platform_id(),
+      .type = d.type(),
+      .name = d.name(),
+      .vendor = d.vendor(),
+      .version = d.version(),
+      .driver_version = d.driver_version(),
+      .profile = d.profile(),
+      .numeric_version = version ? std::optional{*version} : std::nullopt,
+      // Might change between refreshes, thus not memoized
+      .available = query_bool_property_(DevInfo, d.id(), CL_DEVICE_AVAILABLE),
+      .compute_units = d.compute_units(),
+      .max_clock_mhz = d.max_clock(),
+      .global_mem_size = d.global_mem_size(),
+      .max_mem_alloc_size = d.get<device_prop::max_mem_alloc_size>(),
+      .mem_base_addr_align = d.mem_base_addr_align(),
+      .host_unified_memory = d.host_unified_memory(),
+      .fp64 = d.has_fp64(),
+      .fp16 = d.has_fp16(),
+    };
+  }
+
+  // Single failing device must not fail the whole publication, it's listed unavailable
+  static auto _snapshot_or_unavailable(const full_device_id_t &full_id) -> device_snapshot
+  {
+    try {
+      return _snapshot_device(full_id);
+    }
+    catch (...) {
+      // Type of the enumeration, the real one might be unknown as well
+      return {
+        .device = runtime::device{std::get<::cl_device_id>(full_id)},
+        .platform = std::get<::cl_platform_id>(full_id),
+        .type = std::get<::cl_device_type>(full_id),
+        .available = false,
+      };
+    }
+  }
+
+  std::mutex _publishing;
+  std::once_flag _populated;
+
+  std::atomic<snapshot_ptr> _current;
+  std::atomic<std::uint64_t> _generation{0};
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "clapi/runtime/registry.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// device_measurements - what was measured on the device rather than queried
+//----------------------------------------------------------------------------------------
+
+struct device_measurements
+{
+  // Device global memory bandwidth [GB/s]
+  std::optional<double> bandwidth_gbps;
+};
+
+// The default measurement source, nothing was measured.
+struct no_measurements_t
+{
+  static auto operator() (const device_snapshot &) noexcept -> device_measurements
+  {
+    return {};
+  }
+};
+
+constexpr inline no_measurements_t no_measurements{};
+
+template <typename Measure_>
+concept measurement_source =
+  std::is_invocable_r_v<device_measurements, Measure_ &, const device_snapshot &>;
+
+//----------------------------------------------------------------------------------------
+// scoring policies - the higher score, the better device
+//----------------------------------------------------------------------------------------
+//
+// Policy is any callable of `(const device_snapshot &, const device_measurements &)`
+// returning totally ordered score, a number or tuple of keys compared in turn.
+// `scoring_fn` erases type of policy scoring by number, when one selects it at the
+// runtime.
+//
+// Note: Unavailable devices shall be scored `unusable_score` by any policy. {{{
+//       Those are always ranked last.
+// }}}
+
+template <typename Policy_>
+using score_of_t = std::decay_t<std::invoke_result_t<const Policy_ &,
+                                                     const device_snapshot &,
+                                                     const device_measurements &>>;
+
+template <typename Policy_>
+concept scoring_policy =
+  std::is_invocable_v<const Policy_ &, const device_snapshot &, const device_measurements &>
+  and std::totally_ordered<score_of_t<Policy_>>;
+
+using scoring_fn = std::function<double (const device_snapshot &,
+                                         const device_measurements &)>;
+
+constexpr inline double unusable_score = -std::numeric_limits<double>::infinity();
+
+//----------------------------------------------------------------------------------------
+// weighted_scoring - weighted sum of (log-scaled) device properties
+//----------------------------------------------------------------------------------------
+//
+// Magnitudes (compute units × clock, memory size, bandwidth) are compared on log2 scale,
+// so twice as fast device gains the same over any other, whatever its class.
+// Capabilities (fp64, fp16, unified memory) add their weight when present.
+
+struct scoring_weights
+{
+  double throughput = 1.0;
+  double global_memory = 0.25;
+  double bandwidth = 1.0;
+  double host_unified_memory = 0.5;
+  double fp64 = 0.5;
+  double fp16 = 0.25;
+};
+
+struct weighted_scoring
+{
+  scoring_weights weights{};
+
+  auto operator() (const device_snapshot &d, const device_measurements &m) const -> double
+  {
+    if (not d.available) [[unlikely]] return unusable_score;
+
+    auto magnitude = [] (double v) static { return std::log2(1.0 + v); };
+
+    const double mib = double(d.global_mem_size) / double(1 << 20);
+
+    double score = weights.throughput
+                   * magnitude(double(d.compute_units) * double(d.max_clock_mhz))
+                 + weights.global_memory * magnitude(mib);
+
+    if (m.bandwidth_gbps) score += weights.bandwidth * magnitude(*m.bandwidth_gbps);
+
+    if (d.host_unified_memory) score += weights.host_unified_memory;
+    if (d.fp64) score += weights.fp64;
+    if (d.fp16) score += weights.fp16;
+
+    return score;
+  }
+};
+
+// Raw compute throughput, ie. compute units × clock [MHz]
+struct throughput_scoring
+{
+  static auto operator() (const device_snapshot &d, const device_measurements &) -> double
+  {
+    if (not d.available) [[unlikely]] return unusable_score;
+
+    return double(d.compute_units) * double(d.max_clock_mhz);
+  }
+};
+
+// Measured bandwidth, when measured, global memory size otherwise
+struct memory_scoring
+{
+  // Any measured device beats not measured one, whatever its memory size
+  using score_t = std::tuple<bool, double>;
+
+  static auto operator() (const device_snapshot &d, const device_measurements &m)
+    -> score_t
+  {
+    if (not d.available) [[unlikely]] return {false, unusable_score};
+
+    if (m.bandwidth_gbps) return {true, *m.bandwidth_gbps};
+
+    return {false, double(d.global_mem_size) / 1e9};
+  }
+};
+
+//----------------------------------------------------------------------------------------
+// rank - devices ordered from the best scored one
+//----------------------------------------------------------------------------------------
+//
+// Unavailable devices come last, whatever their score. Devices scored equally keep their
+// relative (enumeration) order. Ranked devices refer to the ranged over snapshots, thus
+// those must outlive the result.
+
+template <typename Score_ = double>
+struct ranked_device
+{
+  const device_snapshot *snapshot;
+  Score_ score;
+
+  [[nodiscard]]
+  auto usable() const noexcept -> bool { return snapshot->available; }
+};
+
+template <std::ranges::input_range Range_,
+          scoring_policy Policy_ = weighted_scoring,
+          measurement_source Measure_ = no_measurements_t>
+  requires std::is_lvalue_reference_v<std::ranges::range_reference_t<Range_>>
+           and std::same_as<std::ranges::range_value_t<Range_>, device_snapshot>
+[[nodiscard]]
+auto rank(Range_ &&devices, const Policy_ &policy = {}, Measure_ &&measure = {})
+  -> std::vector<ranked_device<score_of_t<Policy_>>>
+{
+  using ranked_t = ranked_device<score_of_t<Policy_>>;
+
+  std::vector<ranked_t> ranked;
+
+  for (const device_snapshot &d : devices)
+    ranked.push_back({&d, std::invoke(policy, d, std::invoke(measure, d))});
+
+  auto key = [] (const ranked_t &r) { return std::tie(r.snapshot->available, r.score); };
+
+  std::ranges::stable_sort(ranked, std::ranges::greater{}, key);
+
+  return ranked;
+}
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,308 @@
+#pragma once
+
+#include "clapi/etc/basic.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+class staging_ring;
+
+struct staging_ring_options
+{
+  std::size_t slots = 3;                           // 2 for double, 3 for triple buffering
+  std::size_t slot_bytes = std::size_t(16) << 20;  // the largest upload
+};
+
+//----------------------------------------------------------------------------------------
+// staging_slot - pinned host memory of the ring, for the producer to write into
+//----------------------------------------------------------------------------------------
+//
+// Given back to the ring by `staging_ring::submit()`, or unused on destruction.
+
+class staging_slot
+{
+public:
+  staging_slot() noexcept = default;
+
+  staging_slot(staging_slot &&other) noexcept :
+    _ring(std::exchange(other._ring, nullptr)),
+    _index(other._index),
+    _span(std::exchange(other._span, {}))
+  {}
+
+  auto operator=(staging_slot &&other) noexcept -> staging_slot &
+  {
+    staging_slot{std::move(other)}.swap(*this);
+    return *this;
+  }
+
+  ~staging_slot();
+
+  [[nodiscard]]
+  auto span() const noexcept -> std::span<std::byte> { return _span; }
+
+  // Typed view of the slot, as many whole elements as fit
+  template <typename Ty_>
+    requires std::is_trivially_copyable_v<Ty_>
+  [[nodiscard]]
+  auto as() const noexcept -> std::span<Ty_>
+  {
+    return {reinterpret_cast<Ty_ *>(_span.data()), _span.size() / sizeof(Ty_)};
+  }
+
+  [[nodiscard]]
+  auto capacity() const noexcept -> std::size_t { return _span.size(); }
+
+  explicit operator bool() const noexcept { return _ring != nullptr; }
+
+  auto swap(staging_slot &other) noexcept -> void
+  {
+    std::swap(_ring, other._ring);
+    std::swap(_index, other._index);
+    std::swap(_span, other._span);
+  }
+
+private:
+  friend staging_ring;
+
+  staging_slot(staging_ring *ring, std::size_t index, std::span<std::byte> span) noexcept :
+    _ring(ring), _index(index), _span(span)
+  {}
+
+  staging_ring *_ring = nullptr;
+  std::size_t _index = 0;
+  std::span<std::byte> _span;
+};
+
+//----------------------------------------------------------------------------------------
+// staging_ring - pinned slots streaming uploads to the device
+//----------------------------------------------------------------------------------------
+//
+// `clEnqueueWriteBuffer` from pageable memory costs an extra copy by the driver into
+// its pinned staging memory. The ring keeps `slots` buffers of `CL_MEM_ALLOC_HOST_PTR`,
+// mapped once for the whole lifetime, so producers write directly into pinned memory,
+// and the transfer out of it is a plain DMA:
+//
+// ``` c++
+// staging_ring ring{ctx, queue};
+//
+// for (auto &batch : stream)
+// {
+//   auto slot = ring.acquire();                    // blocks while all slots are in flight
+//   auto n = fill(slot->span(), batch);
+//
+//   auto done = ring.submit(*std::move(slot), device_buffer, 0, n);
+// }
+// ```
+//
+// A submitted slot is in flight till the event of its transfer completes. `acquire()`
+// takes a free slot, or the one submitted the earliest, waiting for its transfer.
+// With 2 or 3 slots the producer fills the next batch while previous ones are being
+// uploaded.
+//
+// Note: Uploads are enqueued to the queue of the ring, commands later enqueued to {{{
+//       the same in-order queue see the data, others wait for the event of `submit()`.
+//       Producers may run on any threads, slots are handed out under the lock.
+//       All of slots must be returned before the ring is destroyed.
+// }}}
+
+class staging_ring : immovable<staging_ring>
+{
+public:
+  staging_ring(::cl_context ctx, ::cl_command_queue queue, staging_ring_options options = {}) :
+    _slot_bytes(std::max<std::size_t>(options.slot_bytes, 1))
+  {
+    auto retained = queue_handle::retain(queue);
+    if (!retained) [[unlikely]] throw retained.error();
+
+    _queue = *std::move(retained);
+
+    const std::size_t n = std::max<std::size_t>(options.slots, 1);
+    _slots.reserve(n);
+
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      auto mem = adopt(check<::clCreateBuffer>(ctx, CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR
+                                                    | CL_MEM_HOST_WRITE_ONLY,
+                                               _slot_bytes, nullptr));
+      if (!mem) [[unlikely]]
+      {
+        _unmap_all();
+        throw mem.error();
+      }
+
+      auto p = check<::clEnqueueMapBuffer>(queue, mem->get(), CL_TRUE, CL_MAP_WRITE,
+                                           0, _slot_bytes, 0, nullptr, nullptr);
+      if (!p) [[unlikely]]
+      {
+        _unmap_all();
+        throw p.error();
+      }
+
+      _slots.push_back({*std::move(mem), static_cast<std::byte *>(*p)});
+      _free.push_back(i);
+    }
+  }
+
+  ~staging_ring()
+  {
+    for (auto &f : _in_flight)
+    {
+      ::cl_event ev = f.done.get();
+      std::ignore = check<::clWaitForEvents>(1, &ev);
+    }
+
+    _unmap_all();
+  }
+
+  // Free slot, or the earliest submitted one once its transfer is done
+  [[nodiscard]]
+  auto acquire() -> error_or<staging_slot>
+  {
+    std::unique_lock lock{_mutex};
+
+    // Nothing free nor in flight, all slots are being filled by other producers
+    _returned.wait(lock, [this] { return not _free.empty() or not _in_flight.empty(); });
+
+    if (not _free.empty())
+    {
+      const auto i = _free.back();
+      _free.pop_back();
+
+      return _slot(i);
+    }
+
+    auto earliest = std::move(_in_flight.front());
+    _in_flight.pop_front();
+
+    lock.unlock();
+
+    // Failed transfer is over as well, the slot is free either way
+    ::cl_event ev = earliest.done.get();
+    if (auto r = check<::clWaitForEvents>(1, &ev); !r) [[unlikely]]
+    {
+      _recycle(earliest.slot);
+      return std::unexpected(r.error());
+    }
+
+    return _slot(earliest.slot);
+  }
+
+  // Uploads the first `bytes` of the slot to `dst` at `offset`, event of the transfer
+  [[nodiscard]]
+  auto submit(staging_slot slot,
+              ::cl_mem dst,
+              std::size_t offset,
+              std::size_t bytes,
+              std::span<const ::cl_event> wait = {}) -> error_or<event_handle>
+  {
+    if (slot._ring != this or bytes > slot.capacity()) [[unlikely]]
+      return to_error(CL_INVALID_VALUE);
+
+    ::cl_event done = nullptr;
+
+    // Unsubmitted slot goes back to the free ones on failure
+    if (auto r = check<::clEnqueueWriteBuffer>(_queue.get(), dst, CL_FALSE, offset, bytes,
+                                               slot._span.data(), ::cl_uint(wait.size()),
+                                               wait.empty() ? nullptr : wait.data(), &done);
+        !r) [[unlikely]]
+      return std::unexpected(r.error());
+
+    event_handle owned{done};
+    auto theirs = owned.retained();
+
+    slot._ring = nullptr;
+    {
+      std::scoped_lock lock{_mutex};
+      _in_flight.push_back({slot._index, std::move(owned)});
+    }
+    _returned.notify_one();
+
+    // Transfer starts while the producer fills the next slot
+    std::ignore = check<::clFlush>(_queue.get());
+
+    return theirs;
+  }
+
+  [[nodiscard]]
+  auto slots() const noexcept -> std::size_t { return _slots.size(); }
+
+  [[nodiscard]]
+  auto slot_bytes() const noexcept -> std::size_t { return _slot_bytes; }
+
+  [[nodiscard]]
+  auto queue() const noexcept -> ::cl_command_queue { return _queue.get(); }
+
+private:
+  friend staging_slot;
+
+  struct _slot_t
+  {
+    mem_handle mem;
+    std::byte *host;   // mapped for the lifetime of the ring
+  };
+
+  struct _flight_t
+  {
+    std::size_t slot;
+    event_handle done;
+  };
+
+  auto _slot(std::size_t i) noexcept -> staging_slot
+  {
+    return {this, i, {_slots[i].host, _slot_bytes}};
+  }
+
+  auto _recycle(std::size_t i) noexcept -> void
+  {
+    {
+      std::scoped_lock lock{_mutex};
+      _free.push_back(i);
+    }
+    _returned.notify_one();
+  }
+
+  auto _unmap_all() noexcept -> void
+  {
+    for (auto &s : _slots)
+      std::ignore = check<::clEnqueueUnmapMemObject>(_queue.get(), s.mem.get(), s.host,
+                                                     0, nullptr, nullptr);
+
+    std::ignore = check<::clFinish>(_queue.get());
+  }
+
+  queue_handle _queue;
+  std::size_t _slot_bytes;
+  std::vector<_slot_t> _slots;
+
+  std::mutex _mutex;
+  std::condition_variable _returned;
+  std::vector<std::size_t> _free;
+  std::deque<_flight_t> _in_flight;   // in the order of submission
+};
+
+inline staging_slot::~staging_slot()
+{
+  if (_ring) _ring->_recycle(_index);
+}
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
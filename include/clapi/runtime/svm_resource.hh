@@ -0,0 +1,206 @@
+#pragma once
+
+#include "clapi/etc/basic.hh"
+#include "clapi/runtime/device.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+namespace clapi::runtime
+{
+
+enum class svm_kind
+{
+  coarse_grain,   // host access only between `clEnqueueSVMMap` / `clEnqueueSVMUnmap`
+  fine_grain,     // host and device access at any time (buffer granularity)
+};
+
+// Fine-grain when supported, coarse-grain otherwise, none without SVM
+[[nodiscard]]
+inline auto best_svm_kind(::cl_device_id dev) -> std::optional<svm_kind>
+{
+  const auto caps = runtime::device{dev}.svm_capabilities().value_or(0);
+
+  if (caps & CL_DEVICE_SVM_FINE_GRAIN_BUFFER) return svm_kind::fine_grain;
+  if (caps & CL_DEVICE_SVM_COARSE_GRAIN_BUFFER) return svm_kind::coarse_grain;
+
+  return std::nullopt;
+}
+
+//----------------------------------------------------------------------------------------
+// svm_memory_resource - `std::pmr::memory_resource` of shared virtual memory
+//----------------------------------------------------------------------------------------
+//
+// Allocates by `clSVMAlloc` of the context, so memory is visible to kernels of its
+// devices, and passed by `set_svm_arg()` with no staging copy. Failed allocation throws
+// `std::bad_alloc`, as memory resources do.
+//
+// Note: Every allocation is a driver call, see `svm_pool` for pooling. {{{
+//       Host must not touch coarse-grain memory unless it is mapped (`svm_host_access`),
+//       thus pmr containers (which construct their elements on the host) are meant
+//       for fine-grain memory only. Coarse-grain allocations are for raw use between
+//       mapping and unmapping.
+// }}}
+
+class svm_memory_resource : public std::pmr::memory_resource
+{
+public:
+  svm_memory_resource(::cl_context ctx, svm_kind kind) : _kind(kind)
+  {
+    auto retained = context_handle::retain(ctx);
+    if (!retained) [[unlikely]] throw retained.error();
+
+    _ctx = *std::move(retained);
+  }
+
+  [[nodiscard]]
+  auto kind() const noexcept -> svm_kind { return _kind; }
+
+  [[nodiscard]]
+  auto context() const noexcept -> ::cl_context { return _ctx.get(); }
+
+private:
+  auto _flags() const noexcept -> ::cl_svm_mem_flags
+  {
+    return _kind == svm_kind::fine_grain ? CL_MEM_READ_WRITE | CL_MEM_SVM_FINE_GRAIN_BUFFER
+                                         : CL_MEM_READ_WRITE;
+  }
+
+  auto do_allocate(std::size_t bytes, std::size_t alignment) -> void * override
+  {
+    // Zero alignment is the largest data type of the device
+    void *p = ::clSVMAlloc(_ctx.get(), _flags(), std::max<std::size_t>(bytes, 1),
+                           ::cl_uint(alignment > alignof(std::max_align_t) ? alignment : 0));
+
+    if (p == nullptr) [[unlikely]] throw std::bad_alloc{};
+
+    return p;
+  }
+
+  auto do_deallocate(void *p, std::size_t, std::size_t) -> void override
+  {
+    ::clSVMFree(_ctx.get(), p);
+  }
+
+  auto do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool override
+  {
+    auto *svm = dynamic_cast<const svm_memory_resource *>(&other);
+
+    return svm and svm->_ctx == _ctx and svm->_kind == _kind;
+  }
+
+  context_handle _ctx;
+  svm_kind _kind;
+};
+
+//----------------------------------------------------------------------------------------
+// svm_pool - pooled fine-grain SVM resource, thread-safe
+//----------------------------------------------------------------------------------------
+//
+// The pool keeps its bookkeeping inside blocks of the upstream, written by the host at
+// any time, thus it's built on fine-grain memory only.
+//
+// ``` c++
+// if (best_svm_kind(dev) == svm_kind::fine_grain)
+// {
+//   svm_pool pool{ctx};
+//   std::pmr::vector<float> v(n, &pool);
+//
+//   set_svm_arg(kernel, 0, v.data());
+// }
+// ```
+
+class svm_pool : public std::pmr::memory_resource, immovable<svm_pool>
+{
+public:
+  explicit svm_pool(::cl_context ctx, std::pmr::pool_options options = {}) :
+    _upstream(ctx, svm_kind::fine_grain), _pool(options, &_upstream)
+  {}
+
+  [[nodiscard]]
+  auto kind() const noexcept -> svm_kind { return svm_kind::fine_grain; }
+
+  [[nodiscard]]
+  auto upstream() noexcept -> svm_memory_resource & { return _upstream; }
+
+  // Returns all of memory to the driver, allocations from the pool are invalidated
+  auto release() -> void { _pool.release(); }
+
+private:
+  auto do_allocate(std::size_t bytes, std::size_t alignment) -> void * override
+  {
+    return _pool.allocate(bytes, alignment);
+  }
+
+  auto do_deallocate(void *p, std::size_t bytes, std::size_t alignment) -> void override
+  {
+    _pool.deallocate(p, bytes, alignment);
+  }
+
+  auto do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool override
+  {
+    return this == &other;
+  }
+
+  svm_memory_resource _upstream;
+  std::pmr::synchronized_pool_resource _pool;
+};
+
+//----------------------------------------------------------------------------------------
+// set_svm_arg - SVM pointer as the kernel argument
+//----------------------------------------------------------------------------------------
+
+inline auto set_svm_arg(::cl_kernel kernel, ::cl_uint index, const void *p) -> error_or<>
+{
+  return check<::clSetKernelArgSVMPointer>(kernel, index, p);
+}
+
+//----------------------------------------------------------------------------------------
+// svm_host_access - host access to coarse-grain SVM region, for the scope
+//----------------------------------------------------------------------------------------
+//
+// Maps the region (blocking) on construction, unmaps on destruction. No-op for
+// fine-grain memory, which needs no mapping.
+
+class svm_host_access : immovable<svm_host_access>
+{
+public:
+  svm_host_access(::cl_command_queue queue,
+                  svm_kind kind,
+                  void *p,
+                  std::size_t bytes,
+                  ::cl_map_flags flags = CL_MAP_READ | CL_MAP_WRITE)
+  {
+    if (kind == svm_kind::fine_grain) return;
+
+    auto r = check<::clEnqueueSVMMap>(queue, CL_TRUE, flags, p, bytes, 0, nullptr, nullptr);
+    if (!r) [[unlikely]] throw r.error();
+
+    _queue = queue;
+    _p = p;
+  }
+
+  ~svm_host_access()
+  {
+    if (_p) std::ignore = check<::clEnqueueSVMUnmap>(_queue, _p, 0, nullptr, nullptr);
+  }
+
+private:
+  ::cl_command_queue _queue = nullptr;
+  void *_p = nullptr;
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace clapi::runtime
+{
+
+template <typename Ty_ = void>
+class task;
+
+} // namespace clapi::runtime
+
+namespace clapi::_detail::runtime
+{
+
+// Resumes whoever awaits the finished task, by symmetric transfer
+struct _final_awaiter
+{
+  static auto await_ready() noexcept -> bool { return false; }
+
+  template <typename Promise_>
+  static auto await_suspend(std::coroutine_handle<Promise_> h) noexcept
+    -> std::coroutine_handle<>
+  {
+    if (auto c = h.promise().continuation) return c;
+
+    return std::noop_coroutine();
+  }
+
+  static auto await_resume() noexcept -> void {}
+};
+
+struct _task_promise_base
+{
+  std::coroutine_handle<> continuation;
+  std::exception_ptr error;
+
+  static auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+  static auto final_suspend() noexcept -> _final_awaiter { return {}; }
+
+  auto unhandled_exception() noexcept -> void { error = std::current_exception(); }
+
+  auto rethrow_if_failed() const -> void
+  {
+    if (error) [[unlikely]] std::rethrow_exception(error);
+  }
+};
+
+template <typename Ty_>
+struct _task_promise : _task_promise_base
+{
+  std::optional<Ty_> value;
+
+  auto get_return_object() noexcept -> clapi::runtime::task<Ty_>;
+
+  template <typename From_ = Ty_>
+    requires std::constructible_from<Ty_, From_>
+  auto return_value(From_ &&v) -> void { value.emplace(std::forward<From_>(v)); }
+
+  auto result() -> Ty_
+  {
+    rethrow_if_failed();
+    return *std::move(value);
+  }
+};
+
+template <>
+struct _task_promise<void> : _task_promise_base
+{
+  auto get_return_object() noexcept -> clapi::runtime::task<void>;
+
+  static auto return_void() noexcept -> void {}
+
+  auto result() -> void { rethrow_if_failed(); }
+};
+
+// Fire and forget coroutine, runs eagerly and cleans up after itself
+struct _detached
+{
+  struct promise_type
+  {
+    static auto get_return_object() noexcept -> _detached { return {}; }
+    static auto initial_suspend() noexcept -> std::suspend_never { return {}; }
+    static auto final_suspend() noexcept -> std::suspend_never { return {}; }
+    static auto return_void() noexcept -> void {}
+    static auto unhandled_exception() noexcept -> void { std::terminate(); }
+  };
+};
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// task - lazily started coroutine, runs when awaited
+//----------------------------------------------------------------------------------------
+//
+// Result (or exception) is handed over to the awaiting coroutine, which is resumed
+// on whatever thread the task finished.
+//
+// ``` c++
+// auto answer() -> task<int> { co_return 42; }
+// auto twice() -> task<int> { co_return 2 * co_await answer(); }
+//
+// int v = sync_wait(twice());
+// ```
+
+template <typename Ty_>
+class [[nodiscard]] task
+{
+public:
+  using promise_type = _detail::runtime::_task_promise<Ty_>;
+  using value_type = Ty_;
+
+  task(task &&other) noexcept : _coro(std::exchange(other._coro, {})) {}
+
+  auto operator=(task &&other) noexcept -> task &
+  {
+    if (this != &other)
+    {
+      if (_coro) _coro.destroy();
+      _coro = std::exchange(other._coro, {});
+    }
+
+    return *this;
+  }
+
+  ~task()
+  {
+    if (_coro) _coro.destroy();
+  }
+
+  auto operator co_await() && noexcept
+  {
+    struct awaiter
+    {
+      std::coroutine_handle<promise_type> coro;
+
+      static auto await_ready() noexcept -> bool { return false; }
+
+      auto await_suspend(std::coroutine_handle<> awaiting) noexcept
+        -> std::coroutine_handle<>
+      {
+        coro.promise().continuation = awaiting;
+        return coro;
+      }
+
+      auto await_resume() -> Ty_ { return coro.promise().result(); }
+    };
+
+    return awaiter{_coro};
+  }
+
+private:
+  friend promise_type;
+
+  explicit task(std::coroutine_handle<promise_type> coro) noexcept : _coro(coro) {}
+
+  std::coroutine_handle<promise_type> _coro;
+};
+
+//----------------------------------------------------------------------------------------
+// sync_wait - runs the task, blocking the caller until it is done
+//----------------------------------------------------------------------------------------
+
+template <typename Ty_>
+auto sync_wait(task<Ty_> t) -> Ty_
+{
+  // The promise is owned by the coroutine frame, unlike semaphore (or promise)
+  // of the caller, it stays alive while the other thread returns from `set_value()`.
+  std::promise<Ty_> done;
+  auto result = done.get_future();
+
+  [] (task<Ty_> t, std::promise<Ty_> done) -> _detail::runtime::_detached {
+    try {
+      if constexpr (std::is_void_v<Ty_>)
+      {
+        co_await std::move(t);
+        done.set_value();
+      }
+      else
+        done.set_value(co_await std::move(t));
+    }
+    catch (...) {
+      done.set_exception(std::current_exception());
+    }
+  }(std::move(t), std::move(done));
+
+  return result.get();
+}
+
+} // namespace clapi::runtime
+
+namespace clapi::_detail::runtime
+{
+
+template <typename Ty_>
+inline auto _task_promise<Ty_>::get_return_object() noexcept -> clapi::runtime::task<Ty_>
+{
+  return clapi::runtime::task<Ty_>{
+    std::coroutine_handle<_task_promise>::from_promise(*this)};
+}
+
+inline auto _task_promise<void>::get_return_object() noexcept -> clapi::runtime::task<void>
+{
+  return clapi::runtime::task<void>{
+    std::coroutine_handle<_task_promise>::from_promise(*this)};
+}
+
+} // namespace clapi::_detail::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
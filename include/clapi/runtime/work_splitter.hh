@@ -0,0 +1,387 @@
+#pragma once
+
+#include "clapi/runtime/device_group.hh"
+#include "clapi/runtime/handle.hh"
+#include "clapi/runtime/kernel.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+enum class split_access
+{
+  read,         // slab of the part is copied to the device
+  write,        // slab of the part is copied back to the host
+  read_write,   // both
+  broadcast,    // whole buffer is copied to every device, read-only
+};
+
+//----------------------------------------------------------------------------------------
+// split_buffer - host data of the kernel argument, scattered to (gathered from) parts
+//----------------------------------------------------------------------------------------
+//
+// `item_bytes` is size of the data per single index of the split (outermost) dimension,
+// eg. size of the row for 2-D range split by rows.
+
+struct split_buffer
+{
+  ::cl_uint arg;
+  split_access access;
+  std::span<std::byte> host;
+  std::size_t item_bytes;
+};
+
+struct split_part
+{
+  std::size_t member;
+  std::size_t first;   // first index of the split dimension
+  nd_range range;      // local range of the part (no offset in the split dimension)
+};
+
+} // namespace clapi::runtime
+
+namespace clapi::_detail::runtime
+{
+
+// Largest remainder method: `units` apportioned by `weights` (summing up to 1),
+// counts sum up to `units` exactly.
+constexpr auto _apportion(std::span<const double> weights, std::size_t units)
+  -> std::vector<std::size_t>
+{
+  std::vector<std::size_t> counts(weights.size());
+  std::vector<std::pair<double, std::size_t>> remainders;
+
+  if (weights.empty()) [[unlikely]] return counts;
+
+  std::size_t assigned = 0;
+
+  for (std::size_t i = 0; i < weights.size(); ++i)
+  {
+    const double exact = weights[i] * double(units);
+
+    counts[i] = std::min(std::size_t(exact), units - assigned);
+    assigned += counts[i];
+    remainders.emplace_back(exact - double(counts[i]), i);
+  }
+
+  std::ranges::sort(remainders, std::ranges::greater{});
+
+  for (std::size_t i = 0; assigned < units; ++i, ++assigned)
+    ++counts[remainders[i % remainders.size()].second];
+
+  return counts;
+}
+
+// Initial guesses of throughput, none left at zero: device with no work is never
+// measured, thus it would never get any work either.
+constexpr auto _initial_rates(std::span<const double> guessed, std::size_t members)
+  -> std::vector<double>
+{
+  constexpr double min_share = 0.01;
+
+  if (guessed.empty() or guessed.size() != members)
+    return std::vector<double>(members, 1.0);
+
+  const double top = std::ranges::max(guessed);
+  const double floor = top > 0.0 ? top * min_share : 1.0;
+
+  std::vector<double> rates(members);
+  std::ranges::transform(guessed, rates.begin(), [floor] (double t) {
+    return std::max(t, floor);
+  });
+
+  return rates;
+}
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// work_splitter - static split of the NDRange across devices of the group
+//----------------------------------------------------------------------------------------
+//
+// The outermost dimension of the range is split in contiguous parts, proportional
+// to the throughput of devices, in multiples of the local size. Initial throughput
+// is given (eg. `microbench_results::fp32_gflops`), equal when none is. After each run
+// it is refined from the profiling timestamps of kernels, as work-items per nanosecond
+// of the kernel of the splitter.
+//
+// Kernels (one per member, created in the context of the member) see their part
+// as the whole range: split buffers hold just the slab of the part, and the first
+// index of the part is set to `offset_arg` (as `cl_ulong`) when given.
+//
+// Note: Refinement requires queues with `CL_QUEUE_PROFILING_ENABLE`, {{{
+//       (see `device_group_options`), weights stay as they are otherwise.
+//       Measured rates are smoothed (exponential moving average), the first
+//       measurement replaces the initial guess, which is of other units.
+//
+//       The first queue of each member is used. Buffers of parts are created
+//       for every run, the splitter is meant for kernels that run long enough
+//       for it not to matter.
+// }}}
+
+class work_splitter
+{
+public:
+  static constexpr double smoothing = 0.5;
+
+  // Guesses are raised to 1% of the top one at least, so every device gets measured
+  explicit work_splitter(const device_group &group,
+                         std::span<const double> initial_throughput = {}) :
+    _group(&group),
+    _rates(_detail::runtime::_initial_rates(initial_throughput, group.size()))
+  {}
+
+  // Share of the work per member, sums up to 1
+  [[nodiscard]]
+  auto weights() const -> std::vector<double>
+  {
+    const double total = std::reduce(_rates.begin(), _rates.end());
+
+    std::vector<double> w(_rates.size());
+
+    for (std::size_t i = 0; i < w.size(); ++i)
+      w[i] = total > 0.0 ? _rates[i] / total : 1.0 / double(w.size());
+
+    return w;
+  }
+
+  // Global size of the split dimension must be multiple of the local size (when given)
+  [[nodiscard]]
+  auto plan(const nd_range &range) const -> error_or<std::vector<split_part>>
+  {
+    if (_rates.empty()) [[unlikely]] return {};
+
+    const auto d = range.dims - 1;
+    const std::size_t granule = std::max<std::size_t>(range.local[d], 1);
+
+    if (range.global[d] % granule != 0) [[unlikely]]
+      return to_error(CL_INVALID_WORK_GROUP_SIZE);
+
+    // Each unit is of the local size
+    const auto w = weights();
+    const auto counts = _detail::runtime::_apportion(w, range.global[d] / granule);
+
+    std::vector<split_part> parts;
+    std::size_t first = range.offset[d];
+
+    for (std::size_t i = 0; i < counts.size(); ++i)
+    {
+      if (counts[i] == 0) continue;
+
+      nd_range r = range;
+      r.global[d] = counts[i] * granule;
+      r.offset[d] = 0;
+
+      parts.push_back({i, first, r});
+      first += r.global[d];
+    }
+
+    return parts;
+  }
+
+  // Scatters the buffers, runs the parts, gathers the results, blocks till done
+  auto run(std::span<const ::cl_kernel> kernels,
+           const nd_range &range,
+           std::span<const split_buffer> buffers,
+           std::optional<::cl_uint> offset_arg = std::nullopt) -> error_or<>
+  {
+    if (kernels.size() != _group->size()) [[unlikely]]
+      return to_error(CL_INVALID_VALUE);
+
+    // Slabs of all the parts must be there, in whole
+    const std::size_t items = range.global[range.dims - 1];
+
+    for (const auto &b : buffers)
+      if (b.access != split_access::broadcast
+          and (b.item_bytes == 0 or b.host.size() / b.item_bytes < items)) [[unlikely]]
+        return to_error(CL_INVALID_VALUE);
+
+    const auto planned = plan(range);
+    if (!planned) [[unlikely]] return std::unexpected(planned.error());
+
+    const auto &parts = *planned;
+
+    std::vector<std::vector<mem_handle>> memory(parts.size());
+    std::vector<event_handle> launched(parts.size());
+
+    error_or<> enqueued;
+
+    for (std::size_t p = 0; p < parts.size() and enqueued; ++p)
+      enqueued = _enqueue(parts[p], kernels[parts[p].member], range, buffers, offset_arg,
+                          memory[p], launched[p]);
+
+    // Host memory is in use till commands complete, even when some failed to enqueue
+    error_or<> finished;
+
+    for (const auto &part : parts)
+    {
+      auto r = check<::clFinish>(_group->queue(part.member));
+      if (!r and finished) [[unlikely]] finished = r;
+    }
+
+    if (!enqueued) [[unlikely]] return enqueued;
+    if (!finished) [[unlikely]] return finished;
+
+    _refine(parts, launched, range.dims - 1);
+
+    return {};
+  }
+
+private:
+  auto _enqueue(const split_part &part,
+                ::cl_kernel kernel,
+                const nd_range &range,
+                std::span<const split_buffer> buffers,
+                std::optional<::cl_uint> offset_arg,
+                std::vector<mem_handle> &memory,
+                event_handle &launched) -> error_or<>
+  {
+    const auto d = range.dims - 1;
+    const auto queue = _group->queue(part.member);
+    const auto ctx = (*_group)[part.member].context;
+
+    const std::size_t items = part.range.global[d];
+    const std::size_t start = part.first - range.offset[d];
+
+    auto slab_of = [&] (const split_buffer &b) {
+      return b.host.subspan(start * b.item_bytes, items * b.item_bytes);
+    };
+
+    for (const auto &b : buffers)
+    {
+      const bool whole = b.access == split_access::broadcast;
+      const auto slab = whole ? b.host : slab_of(b);
+
+      auto mem = adopt(check<::clCreateBuffer>(ctx,
+                                               whole ? CL_MEM_READ_ONLY : CL_MEM_READ_WRITE,
+                                               slab.size(), nullptr));
+      if (!mem) [[unlikely]] return std::unexpected(mem.error());
+
+      const ::cl_mem raw = mem->get();
+      memory.push_back(*std::move(mem));
+
+      if (b.access != split_access::write)
+      {
+        auto r = check<::clEnqueueWriteBuffer>(queue, raw, CL_FALSE, 0,
+                                               slab.size(), slab.data(),
+                                               0, nullptr, nullptr);
+        if (!r) [[unlikely]] return r;
+      }
+
+      auto r = check<::clSetKernelArg>(kernel, b.arg, sizeof(raw), &raw);
+      if (!r) [[unlikely]] return r;
+    }
+
+    if (offset_arg)
+    {
+      const ::cl_ulong first = part.first;
+
+      auto r = check<::clSetKernelArg>(kernel, *offset_arg, sizeof(first), &first);
+      if (!r) [[unlikely]] return r;
+    }
+
+    ::cl_event done = nullptr;
+
+    auto r = check<::clEnqueueNDRangeKernel>(queue, kernel, part.range.dims,
+                                             part.range.offset.data(),
+                                             part.range.global.data(),
+                                             part.range.local_size(),
+                                             0, nullptr, &done);
+    if (!r) [[unlikely]] return r;
+
+    launched = event_handle{done};
+
+    for (auto &&[b, mem] : std::views::zip(buffers, memory))
+    {
+      if (b.access != split_access::write and b.access != split_access::read_write)
+        continue;
+
+      auto slab = slab_of(b);
+
+      r = check<::clEnqueueReadBuffer>(queue, mem.get(), CL_FALSE, 0,
+                                       slab.size(), slab.data(), 0, nullptr, nullptr);
+      if (!r) [[unlikely]] return r;
+    }
+
+    // Parts of other devices go on meanwhile
+    return check<::clFlush>(queue);
+  }
+
+  auto _refine(std::span<const split_part> parts,
+               std::span<const event_handle> launched,
+               ::cl_uint d) -> void
+  {
+    using clapi::ExpectedFailure;
+
+    std::vector<std::optional<double>> measured(_rates.size());
+
+    for (auto &&[part, ev] : std::views::zip(parts, launched))
+    {
+      ::cl_ulong start = 0, end = 0;
+
+      if (not check<::clGetEventProfilingInfo>(ExpectedFailure, ev.get(),
+                                               CL_PROFILING_COMMAND_START,
+                                               sizeof(start), &start, nullptr)
+          or not check<::clGetEventProfilingInfo>(ExpectedFailure, ev.get(),
+                                                  CL_PROFILING_COMMAND_END,
+                                                  sizeof(end), &end, nullptr)
+          or end <= start)
+        return;
+
+      double items = 1.0;
+      for (::cl_uint i = 0; i <= d; ++i) items *= double(part.range.global[i]);
+
+      measured[part.member] = items / double(end - start);
+    }
+
+    // Rates of devices left without work (so not measured) are rescaled from the units
+    // of the initial guess, by the ratio of the measured devices.
+    if (not std::exchange(_measured, true))
+    {
+      double guessed = 0.0, actual = 0.0;
+
+      for (std::size_t i = 0; i < _rates.size(); ++i)
+        if (measured[i])
+        {
+          guessed += _rates[i];
+          actual += *measured[i];
+        }
+
+      const double scale = guessed > 0.0 ? actual / guessed : 1.0;
+
+      for (std::size_t i = 0; i < _rates.size(); ++i)
+        _rates[i] = measured[i] ? *measured[i] : _rates[i] * scale;
+
+      return;
+    }
+
+    for (std::size_t i = 0; i < _rates.size(); ++i)
+      if (measured[i])
+        _rates[i] = (1.0 - smoothing) * _rates[i] + smoothing * *measured[i];
+  }
+
+  const device_group *_group;
+  std::vector<double> _rates;
+  bool _measured = false;
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
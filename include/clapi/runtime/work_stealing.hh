@@ -0,0 +1,349 @@
+#pragma once
+
+#include "clapi/runtime/device_group.hh"
+#include "clapi/runtime/query.hh"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace clapi::_detail::runtime
+{
+
+// Range of work items [begin, end) packed to a single word, so both the owner taking
+// from the front and thieves taking from the back are a single CAS.
+class _packed_range
+{
+public:
+  struct range_t
+  {
+    std::uint32_t begin;
+    std::uint32_t end;
+
+    [[nodiscard]]
+    constexpr auto size() const noexcept -> std::uint32_t
+    {
+      return end > begin ? end - begin : 0;
+    }
+
+    friend constexpr auto operator== (range_t, range_t) noexcept -> bool = default;
+  };
+
+  // Taken and left parts of the range, `{taken, left}`
+  using split_t = std::pair<range_t, range_t>;
+
+  auto reset(range_t r) noexcept -> void { _word.store(_pack(r), std::memory_order_release); }
+
+  [[nodiscard]]
+  auto remaining() const noexcept -> std::uint32_t
+  {
+    return _unpack(_word.load(std::memory_order_acquire)).size();
+  }
+
+  // Owner's end, up to `n` items from the front
+  auto take_front(std::uint32_t n) noexcept -> range_t
+  {
+    auto word = _word.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+      auto r = _unpack(word);
+      if (r.size() == 0) return {0, 0};
+
+      auto [taken, left] = split_front(r, n);
+
+      if (_word.compare_exchange_weak(word, _pack(left), std::memory_order_acq_rel))
+        return taken;
+    }
+  }
+
+  // Thieves' end, the back half of what is left
+  auto steal_back() noexcept -> range_t
+  {
+    auto word = _word.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+      auto r = _unpack(word);
+      if (r.size() < 2) return {0, 0};
+
+      auto [taken, left] = split_back(r);
+
+      if (_word.compare_exchange_weak(word, _pack(left), std::memory_order_acq_rel))
+        return taken;
+    }
+  }
+
+  // Up to `n` items from the front, none of an empty range
+  [[nodiscard]]
+  static constexpr auto split_front(range_t r, std::uint32_t n) noexcept -> split_t
+  {
+    if (r.size() == 0) return {{0, 0}, r};
+
+    const std::uint32_t cut = r.begin + std::min(n, r.size());
+    return {{r.begin, cut}, {cut, r.end}};
+  }
+
+  // The back half, rounded down, thus the last item is left to the owner
+  [[nodiscard]]
+  static constexpr auto split_back(range_t r) noexcept -> split_t
+  {
+    if (r.size() < 2) return {{0, 0}, r};
+
+    const std::uint32_t cut = r.end - r.size() / 2;
+    return {{cut, r.end}, {r.begin, cut}};
+  }
+
+private:
+  static constexpr auto _pack(range_t r) noexcept -> std::uint64_t
+  {
+    return std::uint64_t(r.begin) << 32 | r.end;
+  }
+
+  static constexpr auto _unpack(std::uint64_t w) noexcept -> range_t
+  {
+    return {std::uint32_t(w >> 32), std::uint32_t(w)};
+  }
+
+  alignas(64) std::atomic<std::uint64_t> _word{0};
+};
+
+} // namespace clapi::_detail::runtime
+
+namespace clapi::runtime
+{
+
+struct work_stealing_options
+{
+  // Launch latency per member [us], eg. `microbench_results::launch_latency_us`,
+  // 20us for members not given.
+  std::span<const double> launch_latency_us = {};
+
+  // Chunk is sized so that launch latency is at most this fraction of its run time
+  double max_overhead = 0.1;
+
+  std::size_t min_chunk = 1;
+};
+
+struct device_utilization
+{
+  std::size_t items;
+  std::size_t chunks;
+  std::size_t steals;
+  std::chrono::nanoseconds busy;
+  std::chrono::nanoseconds idle;
+
+  [[nodiscard]]
+  auto utilization() const noexcept -> double
+  {
+    const auto total = busy + idle;
+    return total.count() ? double(busy.count()) / double(total.count()) : 0.0;
+  }
+};
+
+// Enqueues the chunk [first, first + count) to the queue of the member
+template <typename Fn_>
+concept chunk_function = std::is_invocable_r_v<error_or<>, Fn_ &, std::size_t,
+                                               ::cl_command_queue, std::size_t,
+                                               std::size_t>;
+
+//----------------------------------------------------------------------------------------
+// work_stealing - dynamic schedule of 1-D work across devices of the group
+//----------------------------------------------------------------------------------------
+//
+// Work is split evenly to per-device queues (packed atomic ranges), each member is driven
+// by its own host thread taking chunks from the front of its queue. Member left
+// without work steals the back half of the fullest queue of the others. No locks are
+// taken while scheduling.
+//
+// Chunk size adapts to each device: it is sized from the measured rate (work items
+// per nanosecond, smoothed) so that launch latency stays below `max_overhead`
+// of the chunk. The first chunk is `min_chunk`, used to measure the rate.
+//
+// ``` c++
+// work_stealing ws{group};
+// auto report = ws.run(batches.size(), [&] (std::size_t m, cl_command_queue q,
+//                                           std::size_t first, std::size_t count) {
+//   return process[m](q, nd_range{count}, first, count);
+// });
+// ```
+//
+// Note: The chunk function is called concurrently for different members, {{{
+//       once it returns, its queue is finished (`clFinish`) and the chunk timed.
+//       The first failure stops all of members and is returned. It is
+//       not to throw, it runs on threads of the scheduler.
+//
+//       Number of work items is limited to 2^32 - 1.
+// }}}
+
+class work_stealing
+{
+public:
+  static constexpr double default_launch_latency_us = 20.0;
+  static constexpr double smoothing = 0.5;
+
+  explicit work_stealing(const device_group &group, work_stealing_options options = {}) :
+    _group(&group), _options(options)
+  {
+    // Empty chunk reads as the queue drained, the run would end with work left undone
+    _options.min_chunk = std::max<std::size_t>(_options.min_chunk, 1);
+  }
+
+  template <chunk_function Fn_>
+  auto run(std::size_t items, Fn_ &&fn) -> error_or<std::vector<device_utilization>>
+  {
+    const std::size_t n = _group->size();
+
+    if (n == 0 or items > std::numeric_limits<std::uint32_t>::max()) [[unlikely]]
+      return to_error(CL_INVALID_VALUE);
+
+    std::vector<_detail::runtime::_packed_range> queues(n);
+    std::vector<device_utilization> report(n);
+
+    for (std::size_t m = 0; m < n; ++m)
+      queues[m].reset({std::uint32_t(items * m / n), std::uint32_t(items * (m + 1) / n)});
+
+    std::atomic<bool> failed{false};
+    std::once_flag first_failure;
+    error_or<> result;
+
+    const auto started = std::chrono::steady_clock::now();
+
+    {
+      std::vector<std::jthread> drivers;
+      drivers.reserve(n);
+
+      for (std::size_t m = 0; m < n; ++m)
+        drivers.emplace_back([&, m] {
+          auto r = _drive(m, queues, fn, report[m], failed);
+
+          if (!r) [[unlikely]]
+          {
+            failed.store(true, std::memory_order_relaxed);
+            std::call_once(first_failure, [&] { result = r; });
+          }
+        });
+    }
+
+    if (!result) [[unlikely]] return std::unexpected(result.error());
+
+    const auto wall = std::chrono::steady_clock::now() - started;
+
+    for (auto &u : report)
+      u.idle = std::chrono::duration_cast<std::chrono::nanoseconds>(wall) - u.busy;
+
+    return report;
+  }
+
+private:
+  using _clock_t = std::chrono::steady_clock;
+
+  auto _drive(std::size_t m,
+              std::span<_detail::runtime::_packed_range> queues,
+              auto &fn,
+              device_utilization &u,
+              const std::atomic<bool> &failed) -> error_or<>
+  {
+    const auto queue = _group->queue(m);
+    const double latency_ns = 1e3 * (m < _options.launch_latency_us.size()
+                                     ? _options.launch_latency_us[m]
+                                     : default_launch_latency_us);
+    double rate = 0.0;   // items per nanosecond, 0 until measured
+
+    while (not failed.load(std::memory_order_relaxed))
+    {
+      std::size_t chunk = _options.min_chunk;
+
+      if (rate > 0.0)
+        chunk = std::max(chunk, std::size_t(rate * latency_ns / _options.max_overhead));
+
+      auto taken = queues[m].take_front(std::uint32_t(std::min<std::size_t>(
+        chunk, std::numeric_limits<std::uint32_t>::max())));
+
+      if (taken.size() == 0)
+      {
+        if (not _steal(m, queues)) return {};
+
+        ++u.steals;
+        continue;
+      }
+
+      const auto start = _clock_t::now();
+
+      error_or<> r = fn(m, queue, std::size_t(taken.begin), std::size_t(taken.size()));
+
+      if (r) [[likely]] r = check<::clFinish>(queue);
+      if (!r) [[unlikely]] return r;
+
+      const auto took = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        _clock_t::now() - start);
+
+      u.busy += took;
+      u.items += taken.size();
+      ++u.chunks;
+
+      const double measured = double(taken.size()) / double(std::max<std::int64_t>(
+        took.count(), 1));
+
+      rate = rate > 0.0 ? (1.0 - smoothing) * rate + smoothing * measured : measured;
+    }
+
+    return {};
+  }
+
+  // Moves the back half of the fullest other queue to ours, false when all are empty
+  static auto _steal(std::size_t m, std::span<_detail::runtime::_packed_range> queues)
+    -> bool
+  {
+    for (;;)
+    {
+      std::size_t victim = m;
+      std::uint32_t most = 0;
+
+      for (std::size_t v = 0; v < queues.size(); ++v)
+      {
+        if (v == m) continue;
+
+        if (auto left = queues[v].remaining(); left > most)
+        {
+          most = left;
+          victim = v;
+        }
+      }
+
+      if (victim == m) return false;
+
+      // Single item left is its owner's, it runs it sooner than we would
+      if (most < 2) return false;
+
+      if (auto stolen = queues[victim].steal_back(); stolen.size())
+      {
+        // Our own queue is empty, nobody steals from it meanwhile
+        queues[m].reset(stolen);
+        return true;
+      }
+    }
+  }
+
+  const device_group *_group;
+  work_stealing_options _options;
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
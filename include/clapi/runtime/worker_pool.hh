@@ -0,0 +1,96 @@
+#pragma once
+
+#include "clapi/etc/basic.hh"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace clapi::runtime
+{
+
+//----------------------------------------------------------------------------------------
+// worker_pool - fixed, bounded set of threads draining a FIFO of posted jobs
+//----------------------------------------------------------------------------------------
+//
+// Note: Jobs escaping with an exception terminate the process. {{{
+//       Callers that need results or errors back are expected to capture them
+//       themselves, see `clapi::runtime::probe`.
+//
+//       On destruction remaining queued jobs are still run, then workers are joined.
+// }}}
+
+class worker_pool : immovable<worker_pool>
+{
+public:
+  using job_t = std::move_only_function<void()>;
+
+  [[nodiscard]]
+  static auto default_concurrency() noexcept -> unsigned
+  {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  explicit worker_pool(unsigned nworkers = default_concurrency())
+  {
+    nworkers = std::max(1u, nworkers);
+
+    _workers.reserve(nworkers);
+    for (unsigned i = 0; i < nworkers; ++i)
+      _workers.emplace_back([this] (std::stop_token st) { _drain(std::move(st)); });
+  }
+
+  // NB: `_workers` being the last member are joined (std::jthread) first.
+  ~worker_pool() = default;
+
+  auto post(job_t job) -> void
+  {
+    {
+      std::scoped_lock lock{_mutex};
+      _jobs.push_back(std::move(job));
+    }
+
+    _wakeup.notify_one();
+  }
+
+  [[nodiscard]]
+  auto size() const noexcept -> unsigned { return _workers.size(); }
+
+private:
+  auto _drain(std::stop_token st) -> void
+  {
+    for (;;)
+    {
+      job_t job;
+      {
+        std::unique_lock lock{_mutex};
+
+        // false only when stop was requested and there's nothing left to run
+        if (not _wakeup.wait(lock, st, [this] { return not _jobs.empty(); }))
+          return;
+
+        job = std::move(_jobs.front());
+        _jobs.pop_front();
+      }
+
+      job();
+    }
+  }
+
+  std::mutex _mutex;
+  std::condition_variable_any _wakeup;
+  std::deque<job_t> _jobs;
+
+  std::vector<std::jthread> _workers;
+};
+
+} // namespace clapi::runtime
+
+/* Best read in VIM {{{
+ * vim: noai : et : fdm=marker :
+ * }}} */
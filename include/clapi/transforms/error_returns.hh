@@ -43,9 +43,9 @@ struct _returning_value_api
 
     given_policy<Always>.then(policy_log_call);
     {
-			::cl_int out_error;
+      ::cl_int out_error;
       if (auto ret = std::invoke_r<return_type>(API_fn,
-                                                clapi::fwd_opt<Params_>>(args)...,
+                                                clapi::fwd_opt<Params_>(args)...,
                                                 &out_error);
           out_error == CLAPI_API_SUCCESS_VALUE) [[likely]]
       {
@@ -187,9 +187,10 @@ consteval auto _select_err_handling()
   }
   else
   {
-    constexpr tseq new_args = _skip_last_param<params_t>{};
+    // Out-error parameter is supplied by `_returning_value_api` itself
+    constexpr tseq new_args = typename _skip_last_param<params_t>::type{};
 
-    return bind_params(_returning_value_api<Fn_>{}, params);
+    return bind_params(_returning_value_api<Fn_>{}, new_args);
   }
 }
 
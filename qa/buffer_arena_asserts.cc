@@ -0,0 +1,42 @@
+#include "clapi/runtime/buffer_arena.hh"
+
+#include <cstddef>
+
+namespace tst_buffer_arena_sanity
+{
+
+using clapi::_detail::runtime::_align_up;
+using clapi::_detail::runtime::_size_class, clapi::_detail::runtime::_size_class_bytes;
+
+static_assert(_align_up(0, 128) == 0);
+static_assert(_align_up(1, 128) == 128);
+static_assert(_align_up(128, 128) == 128);
+static_assert(_align_up(129, 128) == 256);
+static_assert(_align_up(7, 1) == 7);
+
+// Anything up to the smallest class is of class 0
+static_assert(_size_class(0, 256) == 0);
+static_assert(_size_class(1, 256) == 0);
+static_assert(_size_class(256, 256) == 0);
+
+// Then powers of two, exact sizes stay in their own class
+static_assert(_size_class(257, 256) == 1);
+static_assert(_size_class(512, 256) == 1);
+static_assert(_size_class(513, 256) == 2);
+static_assert(_size_class(std::size_t(1) << 20, 256) == 12);
+
+static_assert(_size_class_bytes(0, 256) == 256);
+static_assert(_size_class_bytes(2, 256) == 1024);
+
+// Class fits the request, with less than twice of it
+constexpr auto fits(std::size_t bytes, std::size_t min_class) -> bool
+{
+  const auto size = _size_class_bytes(_size_class(bytes, min_class), min_class);
+
+  return size >= bytes and (size <= min_class or size < 2 * bytes);
+}
+
+static_assert(fits(1, 256) and fits(300, 256) and fits(4096, 256) and fits(4097, 256));
+static_assert(fits(1000, 4096) and fits(12345, 4096) and fits(65536, 4096));
+
+}
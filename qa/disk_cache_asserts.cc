@@ -0,0 +1,36 @@
+#include "clapi/runtime/disk_cache.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace tst_fnv1a_sanity
+{
+
+using clapi::runtime::fnv1a;
+
+constexpr auto hash_of(std::string_view s) -> std::uint64_t
+{
+  std::array<std::byte, 16> bytes{};
+
+  for (std::size_t i = 0; i < s.size(); ++i) bytes[i] = std::byte(s[i]);
+
+  return fnv1a{}.update(std::span{bytes}.first(s.size())).value;
+}
+
+// Reference values of 64-bit FNV-1a
+static_assert(fnv1a{}.value == 0xcbf29ce484222325ull);
+static_assert(hash_of("a") == 0xaf63dc4c8601ec8cull);
+static_assert(hash_of("foobar") == 0x85944171f73967e8ull);
+
+// Strings are length prefixed
+static_assert(fnv1a{}.update("ab").update("c").value
+              != fnv1a{}.update("a").update("bc").value);
+static_assert(fnv1a{}.update("").value != fnv1a{}.value);
+
+static_assert(fnv1a{}.update("abc").value == fnv1a{}.update("abc").value);
+static_assert(fnv1a{}.update("abc").value != fnv1a{}.update("abd").value);
+
+}
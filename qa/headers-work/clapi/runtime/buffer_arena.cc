@@ -0,0 +1 @@
+#include "clapi/runtime/buffer_arena.hh"
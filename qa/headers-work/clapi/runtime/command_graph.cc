@@ -0,0 +1 @@
+#include "clapi/runtime/command_graph.hh"
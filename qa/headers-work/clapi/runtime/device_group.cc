@@ -0,0 +1 @@
+#include "clapi/runtime/device_group.hh"
@@ -0,0 +1 @@
+#include "clapi/runtime/disk_cache.hh"
@@ -0,0 +1 @@
+#include "clapi/runtime/host_buffer.hh"
@@ -0,0 +1 @@
+#include "clapi/runtime/program_cache.hh"
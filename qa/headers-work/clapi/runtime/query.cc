@@ -0,0 +1 @@
+#include "clapi/runtime/query.hh"
@@ -0,0 +1 @@
+#include "clapi/runtime/queue_pool.hh"
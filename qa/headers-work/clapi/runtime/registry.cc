@@ -0,0 +1 @@
+#include "clapi/runtime/registry.hh"
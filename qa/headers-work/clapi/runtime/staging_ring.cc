@@ -0,0 +1 @@
+#include "clapi/runtime/staging_ring.hh"
@@ -0,0 +1 @@
+#include "clapi/runtime/svm_resource.hh"
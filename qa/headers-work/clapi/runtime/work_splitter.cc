@@ -0,0 +1 @@
+#include "clapi/runtime/work_splitter.hh"
@@ -0,0 +1 @@
+#include "clapi/runtime/worker_pool.hh"
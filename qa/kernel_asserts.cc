@@ -0,0 +1,80 @@
+#include "clapi/runtime/kernel.hh"
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace tst_kernel_sanity
+{
+
+using clapi::runtime::kernel, clapi::runtime::nd_range;
+using clapi::runtime::local_memory, clapi::runtime::mem_handle;
+
+// Deleted catch-all templates must win over conversions to the declared signature
+template <typename Kernel_, typename... Given_>
+concept launches = requires (Kernel_ &k, ::cl_command_queue q, Given_ &&...args) {
+  k(q, nd_range{1}, std::forward<Given_>(args)...);
+};
+
+template <typename Kernel_, typename... Given_>
+concept enqueues = requires (Kernel_ &k, ::cl_command_queue q, Given_ &&...args) {
+  k.enqueue(q, nd_range{1}, std::span<const ::cl_event>{}, std::forward<Given_>(args)...);
+};
+
+template <typename Kernel_, typename... Given_>
+concept accepts = launches<Kernel_, Given_...> and enqueues<Kernel_, Given_...>;
+
+template <typename Kernel_, typename... Given_>
+concept rejects = not launches<Kernel_, Given_...> and not enqueues<Kernel_, Given_...>;
+
+// Exact types, lvalues as well
+static_assert(accepts<kernel<::cl_uint>, ::cl_uint>);
+static_assert(accepts<kernel<::cl_uint>, const ::cl_uint &>);
+static_assert(accepts<kernel<::cl_float>, ::cl_float>);
+static_assert(accepts<kernel<::cl_mem>, ::cl_mem>);
+static_assert(accepts<kernel<local_memory>, local_memory>);
+
+// Handles pass for raw objects
+static_assert(accepts<kernel<::cl_mem>, mem_handle>);
+static_assert(accepts<kernel<::cl_mem>, const mem_handle &>);
+
+static_assert(accepts<kernel<::cl_mem, ::cl_float, local_memory, ::cl_uint>,
+                      mem_handle &, ::cl_float, local_memory, ::cl_uint>);
+
+// Implicit conversions don't compile
+static_assert(rejects<kernel<::cl_uint>, int>);
+static_assert(rejects<kernel<::cl_uint>, double>);
+static_assert(rejects<kernel<::cl_uint>, std::nullptr_t>);
+
+static_assert(rejects<kernel<::cl_float>, int>);
+static_assert(rejects<kernel<::cl_float>, double>);
+static_assert(rejects<kernel<::cl_float>, std::nullptr_t>);
+
+static_assert(rejects<kernel<::cl_mem>, int>);
+static_assert(rejects<kernel<::cl_mem>, double>);
+static_assert(rejects<kernel<::cl_mem>, std::nullptr_t>);
+
+// A single inexact argument is enough
+static_assert(rejects<kernel<::cl_mem, ::cl_uint>, mem_handle &, int>);
+
+// Neither does wrong number of arguments
+static_assert(rejects<kernel<::cl_uint, ::cl_uint>, ::cl_uint>);
+static_assert(rejects<kernel<::cl_uint>, ::cl_uint, ::cl_uint>);
+
+template <typename... Ty_>
+concept braced_nd_range = requires (Ty_... v) { nd_range{v...}; };
+
+// 1-D global size only converts, other ranges are spelled by the factories
+static_assert(std::is_convertible_v<std::size_t, nd_range>);
+static_assert(braced_nd_range<std::size_t>);
+static_assert(not braced_nd_range<std::size_t, std::size_t>);
+static_assert(not braced_nd_range<std::size_t, std::size_t, std::size_t>);
+
+static_assert(nd_range::d1(64, 8).dims == 1 and nd_range::d1(64, 8).local[0] == 8);
+static_assert(nd_range::d2({4, 2}).dims == 2 and nd_range::d2({4, 2}).global[1] == 2);
+static_assert(nd_range::d3({4, 2, 3}).global[2] == 3);
+static_assert(nd_range{5}.local_size() == nullptr);
+
+}
@@ -0,0 +1,24 @@
+#include "clapi/transforms/error_returns.hh"
+
+#include <type_traits>
+
+namespace tst_error_returns_sanity
+{
+
+using clapi::error_or, clapi::no_log_error_t;
+using clapi::transforms::check_fn;
+
+cl_int dummy_cl(cl_uint);
+int *dummy_cl_oret(cl_uint, cl_int*);
+
+static_assert(std::is_invocable_r_v<error_or<>, check_fn<dummy_cl>, cl_uint>);
+static_assert(std::is_invocable_r_v<error_or<>, check_fn<dummy_cl>, no_log_error_t, cl_uint>);
+
+// Out-error parameter is supplied by the wrapper, not by the caller
+static_assert(std::is_invocable_r_v<error_or<int *>, check_fn<dummy_cl_oret>, cl_uint>);
+static_assert(std::is_invocable_r_v<error_or<int *>, check_fn<dummy_cl_oret>,
+                                    no_log_error_t, cl_uint>);
+
+static_assert(not std::is_invocable_v<check_fn<dummy_cl_oret>, cl_uint, cl_int*>);
+
+}
@@ -0,0 +1,62 @@
+#include "clapi/runtime/work_splitter.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <numeric>
+#include <vector>
+
+namespace tst_work_splitter_sanity
+{
+
+using clapi::_detail::runtime::_apportion, clapi::_detail::runtime::_initial_rates;
+
+constexpr auto apportions(std::initializer_list<double> weights,
+                          std::size_t units,
+                          std::initializer_list<std::size_t> expected) -> bool
+{
+  auto counts = _apportion({weights.begin(), weights.size()}, units);
+
+  return std::ranges::equal(counts, expected);
+}
+
+constexpr auto apportions_all(std::initializer_list<double> weights, std::size_t units)
+  -> bool
+{
+  auto counts = _apportion({weights.begin(), weights.size()}, units);
+
+  return std::reduce(counts.begin(), counts.end(), std::size_t(0)) == units;
+}
+
+// Exact shares are kept, remainders go to the largest fractions
+static_assert(apportions({.5, .3, .2}, 10, {5, 3, 2}));
+static_assert(apportions({.25, .75}, 3, {1, 2}));
+static_assert(apportions({.15, .05, .8}, 4, {1, 0, 3}));
+
+// Nothing is lost to rounding, nor added
+static_assert(apportions_all({1. / 3, 1. / 3, 1. / 3}, 100));
+static_assert(apportions_all({1. / 3, 1. / 3, 1. / 3}, 2));
+static_assert(apportions_all({.7, .2, .1}, 1));
+static_assert(apportions({1.}, 7, {7}));
+static_assert(apportions({.5, .5}, 0, {0, 0}));
+static_assert(_apportion({}, 5).empty());
+
+constexpr auto initial_rates(std::initializer_list<double> guessed,
+                             std::size_t members,
+                             std::initializer_list<double> expected) -> bool
+{
+  auto rates = _initial_rates({guessed.begin(), guessed.size()}, members);
+
+  return std::ranges::equal(rates, expected);
+}
+
+// Equal when none are given, or not one per member
+static_assert(initial_rates({}, 3, {1., 1., 1.}));
+static_assert(initial_rates({10., 20.}, 3, {1., 1., 1.}));
+
+// None left at zero, at least 1% of the fastest
+static_assert(initial_rates({100., 0.}, 2, {100., 1.}));
+static_assert(initial_rates({100., 50.}, 2, {100., 50.}));
+static_assert(initial_rates({0., 0.}, 2, {1., 1.}));
+
+}
@@ -0,0 +1,32 @@
+#include "clapi/runtime/work_stealing.hh"
+
+namespace tst_work_stealing_sanity
+{
+
+using range_t = clapi::_detail::runtime::_packed_range::range_t;
+using split_t = clapi::_detail::runtime::_packed_range::split_t;
+
+constexpr auto split_front = clapi::_detail::runtime::_packed_range::split_front;
+constexpr auto split_back = clapi::_detail::runtime::_packed_range::split_back;
+
+static_assert(range_t{3, 7}.size() == 4);
+static_assert(range_t{7, 7}.size() == 0);
+static_assert(range_t{7, 3}.size() == 0);
+
+// Owner takes from the front, at most what is left
+static_assert(split_front({0, 10}, 4) == split_t{{0, 4}, {4, 10}});
+static_assert(split_front({6, 10}, 8) == split_t{{6, 10}, {10, 10}});
+static_assert(split_front({10, 10}, 4).first.size() == 0);
+static_assert(split_front({10, 10}, 4).second == range_t{10, 10});
+
+// Thieves take the back half, rounded down
+static_assert(split_back({0, 10}) == split_t{{5, 10}, {0, 5}});
+static_assert(split_back({0, 3}) == split_t{{2, 3}, {0, 2}});
+static_assert(split_back({4, 6}) == split_t{{5, 6}, {4, 5}});
+
+// Single item is left to the owner
+static_assert(split_back({4, 5}).first.size() == 0);
+static_assert(split_back({4, 5}).second == range_t{4, 5});
+static_assert(split_back({5, 5}).first.size() == 0);
+
+}